@@ -0,0 +1,92 @@
+/* Copyright 2025 Vulcalien
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "log.h"
+
+// the event table is shared with the firmware
+#include "../../../firmware/apps/tof/src/log-events.c"
+
+// Formats the raw log records printed by the sensor's console after
+// 'tof log raw'. Reads the console output from stdin and copies the
+// other lines as they are.
+
+// cycle counter frequency, 0 if not known yet
+static unsigned long cycles_per_us;
+
+static bool has_previous;
+static uint32_t previous_cycles;
+
+static void format_entry(const char *line) {
+    unsigned long time_ms, cycles;
+    unsigned event;
+    int offset;
+    if(sscanf(line, "%lx %lx %x%n", &time_ms, &cycles, &event, &offset) < 3) {
+        printf("[Logfmt] invalid record: %s", line);
+        return;
+    }
+    line += offset;
+
+    int16_t args[LOG_MAX_ARGS];
+    int nargs = 0;
+
+    unsigned arg;
+    while(nargs < LOG_MAX_ARGS && sscanf(line, "%x%n", &arg, &offset) == 1) {
+        args[nargs++] = (int16_t) arg;
+        line += offset;
+    }
+
+    printf("[%6lu.%03lu] ", time_ms / 1000, time_ms % 1000);
+
+    // time since the previous entry, more precise than milliseconds
+    if(has_previous && cycles_per_us != 0) {
+        const uint32_t delta = (uint32_t) cycles - previous_cycles;
+        printf("+%10.1f us  ", (double) delta / cycles_per_us);
+    } else {
+        printf("%*s", 16, "");
+    }
+    has_previous = true;
+    previous_cycles = cycles;
+
+    char text[256];
+    log_format(text, sizeof(text), event, args, nargs);
+    puts(text);
+}
+
+int main(int argc, char *argv[]) {
+    char line[512];
+    while(fgets(line, sizeof(line), stdin)) {
+        unsigned long value;
+
+        if(!strncmp(line, "@L ", 3)) {
+            format_entry(&line[3]);
+        } else if(sscanf(line, "@F %lx", &value) == 1) {
+            cycles_per_us = value / 1000000;
+            has_previous = false;
+        } else if(sscanf(line, "@D %lx", &value) == 1) {
+            printf("[Log] %lu messages dropped\n", value);
+            has_previous = false;
+        } else {
+            fputs(line, stdout);
+        }
+        fflush(stdout);
+    }
+    return EXIT_SUCCESS;
+}
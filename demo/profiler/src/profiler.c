@@ -0,0 +1,192 @@
+/* Copyright 2025 Vulcalien
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <unistd.h>
+#include <errno.h>
+
+#include <net/if.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+
+#include <linux/can.h>
+
+#include "libtofcan.h"
+#include "tof2can.h"
+
+// Requests the cycle profile of a sensor and prints it.
+
+static int sockfd;
+
+#define RTR_BIT (1 << 30)
+
+// give up if the sensor does not reply within this time
+#define REPLY_TIMEOUT_MS 1000
+
+static int can_open(const char *ifname) {
+    if((sockfd = socket(PF_CAN, SOCK_RAW, CAN_RAW)) < 0) {
+        perror("Socket");
+        return 1;
+    }
+
+    struct ifreq ifr = { 0 };
+    strcpy(ifr.ifr_name, ifname);
+    ioctl(sockfd, SIOCGIFINDEX, &ifr);
+
+    struct sockaddr_can addr = { 0 };
+    addr.can_family  = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+
+    if(bind(sockfd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        perror("Bind");
+        return 1;
+    }
+
+    const struct timeval timeout = {
+        .tv_sec  = REPLY_TIMEOUT_MS / 1000,
+        .tv_usec = (REPLY_TIMEOUT_MS % 1000) * 1000
+    };
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return 0;
+}
+
+static int can_write(const struct libtofcan_msg *msg) {
+    struct can_frame frame;
+    frame.can_id  = msg->id | (msg->rtr * RTR_BIT);
+    frame.can_dlc = msg->len;
+    memcpy(frame.data, msg->data, msg->len);
+
+    const int frame_size = sizeof(struct can_frame);
+    if(write(sockfd, &frame, frame_size) != frame_size) {
+        perror("CAN write");
+        return -1;
+    }
+    return msg->len;
+}
+
+static int can_read(struct libtofcan_msg *msg) {
+    struct can_frame frame;
+    if(read(sockfd, &frame, sizeof(struct can_frame)) < 0) {
+        if(errno != EAGAIN)
+            perror("CAN read");
+        return -1;
+    }
+
+    msg->id  = frame.can_id & ~RTR_BIT;
+    msg->rtr = frame.can_id & RTR_BIT;
+    msg->len = frame.can_dlc;
+    memcpy(msg->data, frame.data, msg->len);
+
+    return msg->len;
+}
+
+static int requested_sensor;
+static bool done = false;
+
+static void print_step(const struct libtofcan_profile *data, int step,
+                       const char *name) {
+    const double cycles_per_us = data->cycles_per_us;
+    const uint32_t *histogram = data->steps[step].histogram;
+
+    printf(
+        "%-9s %u times, min %.1f us, mean %.1f us, max %.1f us\n",
+        name, data->steps[step].count,
+        data->steps[step].min  / cycles_per_us,
+        data->steps[step].mean / cycles_per_us,
+        data->steps[step].max  / cycles_per_us
+    );
+
+    for(int b = 0; b < TOF2CAN_PROFILE_BUCKET_COUNT; b++) {
+        if(histogram[b] == 0)
+            continue;
+
+        const double low  = (b == 0 ? 0 : 1u << (b + 7));
+        const double high = 1u << (b + 8);
+        if(b == TOF2CAN_PROFILE_BUCKET_COUNT - 1)
+            printf("  %9.1f us or more   ", low / cycles_per_us);
+        else
+            printf(
+                "  %9.1f - %-9.1f us ",
+                low / cycles_per_us, high / cycles_per_us
+            );
+
+        // the sensor saturates the counts
+        printf("%u%s\n", histogram[b], histogram[b] == 0xffff ? "+" : "");
+    }
+}
+
+static void callback_profile(int sensor, struct libtofcan_profile *data,
+                             bool valid) {
+    static const char *names[TOF2CAN_PROFILE_STEP_COUNT] = {
+        [TOF2CAN_PROFILE_STEP_READ]      = "read",
+        [TOF2CAN_PROFILE_STEP_PROCESS]   = "process",
+        [TOF2CAN_PROFILE_STEP_THRESHOLD] = "threshold",
+        [TOF2CAN_PROFILE_STEP_WRITE]     = "write"
+    };
+
+    if(sensor != requested_sensor)
+        return;
+
+    if(!valid) {
+        printf("[Profiler] some messages of the reply were lost\n");
+        done = true;
+        return;
+    }
+    if(data->cycles_per_us == 0) {
+        printf("[Profiler] invalid reply (0 cycles per us)\n");
+        done = true;
+        return;
+    }
+
+    printf("sensor %d, %d cycles per us\n", sensor, data->cycles_per_us);
+    for(int s = 0; s < TOF2CAN_PROFILE_STEP_COUNT; s++)
+        print_step(data, s, names[s]);
+    done = true;
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 2) {
+        printf("Usage: %s <sensor-id> [interface]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    requested_sensor = atoi(argv[1]) % TOF2CAN_MAX_SENSOR_COUNT;
+
+    const char *ifname = (argc > 2 ? argv[2] : "can0");
+    if(can_open(ifname))
+        return EXIT_FAILURE;
+
+    libtofcan_set_profile_callback(callback_profile);
+
+    struct libtofcan_msg msg;
+    libtofcan_profile_request(requested_sensor, &msg);
+    if(can_write(&msg) < 0)
+        return EXIT_FAILURE;
+
+    while(!done) {
+        if(can_read(&msg) < 0) {
+            printf("[Profiler] no reply from sensor %d\n", requested_sensor);
+            return EXIT_FAILURE;
+        }
+        libtofcan_receive(&msg);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define HAS_CYCLE_COUNTER
+#endif
+
+// Host-side benchmarks of the firmware's processing code. Times are
+// measured on the host, so they are only meaningful relative to each
+// other (e.g. when comparing two implementations).
+
+static inline uint64_t get_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint64_t get_cycles(void) {
+    #ifdef HAS_CYCLE_COUNTER
+        return __rdtsc();
+    #else
+        return 0;
+    #endif
+}
+
+// Discards the output of the firmware (e.g. setters logging values).
+extern void quiet_begin(void);
+extern void quiet_end(void);
+
+// Benchmark suites: each returns the number of errors found.
+extern int bench_selection(void);
+extern int bench_pipeline(void);
+extern int bench_i2c(void);
+extern int bench_decode(void);
+extern int bench_queue(void);
+
+/* ================================================================== */
+/*                            Host stubs                              */
+/* ================================================================== */
+
+// ToF frame returned by the next call to 'tof_read_data'
+extern struct bench_frame {
+    int16_t  distance[64];
+    uint8_t  status[64];
+    uint16_t sigma[64];
+    uint32_t signal_per_spad[64];
+} bench_frame;
+
+// CAN messages written by the firmware
+extern struct bench_can_stats {
+    uint64_t frames;
+    uint64_t bytes; // data bytes, excluding CAN headers
+} bench_can_stats;
+
+// If true, writes fail as if the TX FIFO was full
+extern bool bench_can_full;
+
+// Sets up the sensors of can-io.c, as 'can_io_init' does without the
+// CAN device
+extern void bench_can_init(void);
+
+// Runs the firmware's sender once, see 'sender_run' in can-io.c
+extern int bench_can_send(void);
+
+// Queues a telemetry report of the given sensor
+extern void bench_can_send_telemetry(int sensor);
+
+// Writes the queued messages, see 'tx_flush' in can-io.c
+extern void bench_can_flush(void);
+
+// Register space of the simulated I2C device
+#define BENCH_I2C_MEMORY_SIZE 0x10000
+extern uint8_t bench_i2c_memory[BENCH_I2C_MEMORY_SIZE];
+
+// I2C transactions received by the simulated device
+extern struct bench_i2c_stats {
+    uint64_t transactions;
+    uint64_t bytes;  // register address and data bytes
+    uint64_t bus_ns; // estimated time on the bus
+    int errors;      // out-of-range accesses
+} bench_i2c_stats;
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vl53l5cx_api.h"
+#include "decode.h"
+
+#define FRAME_COUNT 64
+#define REPETITIONS 64
+
+#define TARGETS VL53L5CX_NB_TARGET_PER_ZONE
+
+static VL53L5CX_Configuration dev;
+static VL53L5CX_ResultsData   uld_results;
+static struct decode_output   fast_results;
+
+static struct {
+    uint8_t data[VL53L5CX_MAX_RESULTS_SIZE];
+    int size;
+} frames[FRAME_COUNT];
+
+/* ================================================================== */
+/*                          Frame generation                          */
+/* ================================================================== */
+
+// Frames are built as the ULD sees them after byte-swapping, then each
+// word is swapped back to the order sent by the sensor.
+static uint8_t swapped[VL53L5CX_MAX_RESULTS_SIZE];
+static int position;
+
+static void add_block(uint32_t header, int size, const void *data) {
+    union Block_header bh = { .bytes = header };
+    if(size >= 0)
+        bh.size = size;
+
+    memcpy(&swapped[position], &bh.bytes, 4);
+    position += 4;
+
+    const int data_size = (bh.type > 0x1 && bh.type < 0xd)
+        ? bh.type * bh.size
+        : bh.size;
+    if(data)
+        memcpy(&swapped[position], data, data_size);
+    position += data_size;
+}
+
+static void generate_frame(int f, int zones, bool all_outputs,
+                           bool corrupted) {
+    int16_t  distance[64 * TARGETS];
+    uint8_t  status[64 * TARGETS];
+    uint16_t sigma[64 * TARGETS];
+    uint32_t signal[64 * TARGETS];
+    uint8_t  nb_targets[64];
+
+    for(int i = 0; i < zones * TARGETS; i++) {
+        distance[i] = rand() % 16400 - 400; // raw format: mm * 4
+        status[i]   = rand() % 14;
+        sigma[i]    = rand();
+        signal[i]   = (uint32_t) rand() << 4;
+    }
+    for(int z = 0; z < zones; z++)
+        nb_targets[z] = (rand() % 8 == 0 ? 0 : 1);
+
+    memset(swapped, 0, sizeof(swapped));
+    const uint16_t id = rand();
+    swapped[0x8] = id >> 8;
+    swapped[0x9] = id;
+
+    // blocks, in the order of vl53l5cx_start_ranging
+    position = 16;
+    add_block(VL53L5CX_METADATA_BH, -1, NULL);
+    add_block(VL53L5CX_COMMONDATA_BH, -1, NULL);
+    add_block(VL53L5CX_NB_TARGET_DETECTED_BH, zones, nb_targets);
+    if(all_outputs) {
+        add_block(VL53L5CX_SIGNAL_RATE_BH, zones * TARGETS, signal);
+        add_block(VL53L5CX_RANGE_SIGMA_MM_BH, zones * TARGETS, sigma);
+    }
+    add_block(VL53L5CX_DISTANCE_BH, zones * TARGETS, distance);
+    add_block(VL53L5CX_TARGET_STATUS_BH, zones * TARGETS, status);
+
+    // footer, repeating the header ID
+    position += 4;
+    swapped[position]     = id >> 8;
+    swapped[position + 1] = id + corrupted;
+    position += 4;
+
+    frames[f].size = position;
+    for(int i = 0; i < position; i += 4) {
+        uint32_t word;
+        memcpy(&word, &swapped[i], 4);
+        word = __builtin_bswap32(word);
+        memcpy(&frames[f].data[i], &word, 4);
+    }
+}
+
+/* ================================================================== */
+/*                              Decoders                              */
+/* ================================================================== */
+
+static int uld_decode(int f) {
+    memcpy(bench_i2c_memory, frames[f].data, frames[f].size);
+    dev.data_read_size = frames[f].size;
+    return (vl53l5cx_get_ranging_data(&dev, &uld_results) != 0);
+}
+
+static int fast_decode(int f, int zones) {
+    memcpy(bench_i2c_memory, frames[f].data, frames[f].size);
+    if(VL53L5CX_RdMulti(&dev.platform, 0x0,
+                        dev.temp_buffer, frames[f].size))
+        return 1;
+    dev.streamcount = dev.temp_buffer[0];
+
+    return decode_frame(dev.temp_buffer, frames[f].size, zones,
+                        &fast_results);
+}
+
+static int compare(int zones, bool all_outputs) {
+    for(int i = 0; i < zones * TARGETS; i++) {
+        if(fast_results.distance_mm[i]   != uld_results.distance_mm[i] ||
+           fast_results.target_status[i] != uld_results.target_status[i])
+            return 1;
+
+        if(all_outputs && (
+           fast_results.range_sigma_mm[i]  != uld_results.range_sigma_mm[i] ||
+           fast_results.signal_per_spad[i] != uld_results.signal_per_spad[i]))
+            return 1;
+    }
+    for(int z = 0; z < zones; z++) {
+        if(fast_results.nb_target_detected[z] !=
+           uld_results.nb_target_detected[z])
+            return 1;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/*                              Benchmark                             */
+/* ================================================================== */
+
+static int check(int zones, bool all_outputs) {
+    int errors = 0;
+
+    for(int f = 0; f < FRAME_COUNT; f++) {
+        const bool corrupted = (f % 16 == 15);
+        generate_frame(f, zones, all_outputs, corrupted);
+
+        const int uld_err  = uld_decode(f);
+        const int fast_err = fast_decode(f, zones);
+
+        if(uld_err != corrupted || fast_err != corrupted) {
+            printf(
+                "  [!] frame %d: corrupted=%d, ULD err=%d, fast err=%d\n",
+                f, corrupted, uld_err, fast_err
+            );
+            errors++;
+        } else if(!corrupted && compare(zones, all_outputs)) {
+            printf("  [!] frame %d: decoders disagree\n", f);
+            errors++;
+        }
+    }
+
+    // only keep valid frames for benchmarking
+    for(int f = 0; f < FRAME_COUNT; f++)
+        generate_frame(f, zones, all_outputs, false);
+    return errors;
+}
+
+static void run(int zones, bool all_outputs) {
+    uint64_t uld_ns  = 0;
+    uint64_t fast_ns = 0;
+
+    for(int r = 0; r < REPETITIONS; r++) {
+        for(int f = 0; f < FRAME_COUNT; f++) {
+            const uint64_t start = get_ns();
+            uld_decode(f);
+            const uint64_t uld_end = get_ns();
+            fast_decode(f, zones);
+            const uint64_t fast_end = get_ns();
+
+            uld_ns  += uld_end - start;
+            fast_ns += fast_end - uld_end;
+        }
+    }
+
+    const int iterations = REPETITIONS * FRAME_COUNT;
+    printf(
+        "  %dx%-3d %-8s %6d %9.1f %9.1f %8.2fx\n",
+        zones == 16 ? 4 : 8, zones == 16 ? 4 : 8,
+        all_outputs ? "all" : "minimal", frames[0].size,
+        (double) uld_ns / iterations, (double) fast_ns / iterations,
+        (double) uld_ns / fast_ns
+    );
+}
+
+int bench_decode(void) {
+    int errors = 0;
+
+    srand(1234);
+    dev.platform.address = VL53L5CX_DEFAULT_I2C_ADDRESS;
+    vl53l5cx_platform_set_transfer(1000000, 0);
+
+    printf(
+        "ranging data decode (incl. copy from simulated bus):\n"
+        "  %-5s %-8s %6s %9s %9s %9s\n",
+        "res", "outputs", "bytes", "ULD ns", "fast ns", "speedup"
+    );
+    for(int r = 0; r < 2; r++) {
+        const int zones = (r == 0 ? 16 : 64);
+
+        for(int o = 0; o < 2; o++) {
+            const bool all_outputs = (o == 1);
+
+            errors += check(zones, all_outputs);
+            run(zones, all_outputs);
+        }
+    }
+    printf("  (ns per frame; 'minimal' = distance and status only)\n");
+
+    vl53l5cx_platform_set_transfer(400000, 0);
+    return errors;
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+// Host build of can-io.c: CAN messages are counted instead of being
+// written to the CAN device.
+#define _GNU_SOURCE
+#include <sys/types.h>
+
+#define SCHED_PRIORITY_MAX 255
+
+#define write bench_can_write
+#include "../../src/can-io.c"
+#undef write
+
+#include "bench.h"
+
+struct bench_can_stats bench_can_stats;
+bool bench_can_full;
+
+ssize_t bench_can_write(int fd, const void *buf, size_t nbytes) {
+    const struct can_msg_s *msg = buf;
+
+    if(bench_can_full) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    bench_can_stats.frames++;
+    bench_can_stats.bytes += msg->cm_hdr.ch_dlc;
+    return nbytes;
+}
+
+void bench_can_init(void) {
+    for(int i = 0; i < TOF_MAX_SENSORS; i++)
+        sensors[i].index = i;
+}
+
+int bench_can_send(void) {
+    return sender_run();
+}
+
+void bench_can_send_telemetry(int sensor) {
+    write_telemetry(&sensors[sensor], get_ms());
+}
+
+void bench_can_flush(void) {
+    tx_flush();
+}
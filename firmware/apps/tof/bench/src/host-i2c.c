@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <nuttx/i2c/i2c_master.h>
+
+// Test double of the I2C bus: a single device, whose registers are
+// stored in memory. Each transaction starts with a 2-byte register
+// address, followed by the data read or written.
+
+struct i2c_master_s {
+    int unused;
+};
+
+static struct i2c_master_s bus;
+struct i2c_master_s *i2cmain = &bus;
+
+uint8_t bench_i2c_memory[BENCH_I2C_MEMORY_SIZE];
+struct bench_i2c_stats bench_i2c_stats;
+
+// Accounts a transaction made of the given number of bytes, plus one
+// device address byte per (repeated) start condition. Each byte takes 9
+// clock cycles, and start/stop conditions about one each.
+static void count_transaction(const struct i2c_config_s *config,
+                              int bytes, int starts) {
+    const uint64_t cycles = (uint64_t) (bytes + starts) * 9 + starts + 1;
+
+    bench_i2c_stats.transactions++;
+    bench_i2c_stats.bytes  += bytes;
+    bench_i2c_stats.bus_ns += cycles * 1000000000 / config->frequency;
+}
+
+static int device_access(int address, uint8_t *data, int length, bool write) {
+    if(address + length > BENCH_I2C_MEMORY_SIZE) {
+        bench_i2c_stats.errors++;
+        return -1;
+    }
+
+    if(write)
+        memcpy(&bench_i2c_memory[address], data, length);
+    else
+        memcpy(data, &bench_i2c_memory[address], length);
+    return 0;
+}
+
+int i2c_write(struct i2c_master_s *dev,
+              const struct i2c_config_s *config,
+              const uint8_t *buffer, int buflen) {
+    count_transaction(config, buflen, 1);
+
+    const int address = buffer[0] << 8 | buffer[1];
+    return device_access(address, (uint8_t *) &buffer[2], buflen - 2, true);
+}
+
+int i2c_writeread(struct i2c_master_s *dev,
+                  const struct i2c_config_s *config,
+                  const uint8_t *wbuffer, int wbuflen,
+                  uint8_t *rbuffer, int rbuflen) {
+    const int address = wbuffer[0] << 8 | wbuffer[1];
+
+    // negative read length: write without a repeated start
+    if(rbuflen < 0) {
+        count_transaction(config, wbuflen - rbuflen, 1);
+        return device_access(address, rbuffer, -rbuflen, true);
+    }
+
+    count_transaction(config, wbuflen + rbuflen, 2);
+    return device_access(address, rbuffer, rbuflen, false);
+}
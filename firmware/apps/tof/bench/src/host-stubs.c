@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include "main.h"
+#include "tof.h"
+#include "timing.h"
+#include "storage.h"
+#include "log.h"
+#include "sync.h"
+
+// Host replacements of the modules that depend on the hardware.
+
+volatile uint32_t main_loop_count;
+
+void board_userled(int led, bool ledon) {
+}
+
+/* ================================================================== */
+/*                                ToF                                 */
+/* ================================================================== */
+
+// a single sensor
+int tof_sensor_count = 1;
+
+static int tof_matrix_width = 8;
+
+struct bench_frame bench_frame;
+
+// copy of the frame, since processing modifies it
+static struct bench_frame read_frame;
+
+int tof_get_matrix_width(int sensor) {
+    return tof_matrix_width;
+}
+
+void tof_start_ranging(int sensor) {
+}
+
+void tof_stop_ranging(int sensor) {
+}
+
+int tof_read_data(int sensor, struct tof_data *data) {
+    // bench frames have a single target per zone
+    static uint8_t nb_targets[64];
+    memset(nb_targets, 1, sizeof(nb_targets));
+
+    read_frame = bench_frame;
+
+    data->stride          = 1;
+    data->captured        = 0;
+    data->nb_targets      = nb_targets;
+    data->distance        = read_frame.distance;
+    data->status          = read_frame.status;
+    data->sigma           = read_frame.sigma;
+    data->signal_per_spad = read_frame.signal_per_spad;
+    return 0;
+}
+
+// bench frames always carry all outputs
+static int tof_outputs;
+
+int tof_set_outputs(int sensor, int outputs) {
+    tof_outputs = outputs;
+    return 0;
+}
+
+int tof_get_outputs(int sensor) {
+    return tof_outputs;
+}
+
+int tof_set_resolution(int sensor, int resolution) {
+    tof_matrix_width = (resolution == 16 ? 4 : 8);
+    return 0;
+}
+
+int tof_set_frequency(int sensor, int frequency_hz) {
+    return 0;
+}
+
+int tof_set_sharpener(int sensor, int sharpener_percent) {
+    return 0;
+}
+
+uint32_t tof_get_i2c_errors(void) {
+    return 0;
+}
+
+/* ================================================================== */
+/*                               Timing                               */
+/* ================================================================== */
+
+void timing_begin(int stage) {
+}
+
+void timing_end(int stage, bool completed) {
+}
+
+uint32_t timing_profile_begin(void) {
+    return 0;
+}
+
+void timing_profile_end(int profile, uint32_t start) {
+}
+
+void timing_profile_read(int profile, struct timing_profile *data) {
+    memset(data, 0, sizeof(*data));
+}
+
+/* ================================================================== */
+/*                                Log                                 */
+/* ================================================================== */
+
+// the bench measures processing alone: messages are discarded
+
+volatile int log_level = LOG_LEVEL_ERROR;
+
+void log_write(int event, const int16_t *args, int nargs) {
+}
+
+/* ================================================================== */
+/*                                Sync                                */
+/* ================================================================== */
+
+// bus time is never synced on the host
+
+void sync_handle(uint64_t host_us, uint32_t cycles) {
+}
+
+bool sync_get_time(uint32_t cycles, uint64_t *time_us) {
+    *time_us = 0;
+    return false;
+}
+
+/* ================================================================== */
+/*                              Storage                               */
+/* ================================================================== */
+
+// the host has no flash: nothing is ever stored
+
+int storage_read(int key, void *data, int size) {
+    return 1;
+}
+
+int storage_write(int key, const void *data, int size) {
+    return 1;
+}
+
+int storage_erase(int key) {
+    return 0;
+}
+
+/* ================================================================== */
+/*                            CAN filters                             */
+/* ================================================================== */
+
+// the host CAN device receives nothing: filters are not needed
+
+int stm32l4_can_setfilters(const uint16_t *ids, const uint16_t *masks,
+                           int count) {
+    return 0;
+}
+
+int stm32l4_can_getfilter(int index, uint16_t *id, uint16_t *mask) {
+    return -ERANGE;
+}
+
+bool stm32l4_can_rxoverrun(void) {
+    return false;
+}
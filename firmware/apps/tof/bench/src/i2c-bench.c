@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vl53l5cx_api.h"
+
+#define FRAME_COUNT 64
+
+// firmware upload: three pages written at address 0, see vl53l5cx_init
+static const uint32_t firmware_pages[] = { 0x8000, 0x8000, 0x5000 };
+
+static const struct {
+    uint32_t frequency;
+    uint32_t chunk_size;
+} settings[] = {
+    { 400000,  32 },
+    { 400000,  0  },
+    { 1000000, 32 },
+    { 1000000, 255 },
+    { 1000000, 0  }
+};
+
+static uint8_t source[0x8000];
+static uint8_t buffer[0x8000];
+
+static VL53L5CX_Platform platform = { .address = VL53L5CX_DEFAULT_I2C_ADDRESS };
+
+static void reset_stats(void) {
+    bench_i2c_stats = (struct bench_i2c_stats) { 0 };
+    vl53l5cx_i2c_stats = (struct vl53l5cx_i2c_stats) { 0 };
+}
+
+// Checks that the platform layer accounted for the same traffic that
+// the simulated device received.
+static int check_stats(void) {
+    const int errors = bench_i2c_stats.errors;
+    if(vl53l5cx_i2c_stats.transactions != bench_i2c_stats.transactions ||
+       vl53l5cx_i2c_stats.bytes != bench_i2c_stats.bytes) {
+        printf("  [!] platform I2C stats do not match the bus\n");
+        return errors + 1;
+    }
+    return errors;
+}
+
+static void print_result(const char *name, int setting, int count) {
+    printf(
+        "  %-9s %7u %5u %10.1f %10.1f %10.3f\n",
+        name, (unsigned) settings[setting].frequency,
+        (unsigned) settings[setting].chunk_size,
+        (double) bench_i2c_stats.transactions / count,
+        (double) bench_i2c_stats.bytes / count,
+        (double) bench_i2c_stats.bus_ns / count / 1000000
+    );
+}
+
+static int bench_upload(int setting) {
+    int errors = 0;
+    reset_stats();
+
+    for(int p = 0; p < sizeof(firmware_pages) / sizeof(uint32_t); p++) {
+        const uint32_t size = firmware_pages[p];
+        errors += (VL53L5CX_WrMulti(&platform, 0, source, size) != 0);
+
+        if(memcmp(bench_i2c_memory, source, size)) {
+            printf("  [!] firmware page %d was not written correctly\n", p);
+            errors++;
+        }
+    }
+    errors += check_stats();
+
+    print_result("upload", setting, 1);
+    return errors;
+}
+
+static int bench_frame_read(int setting) {
+    int errors = 0;
+    reset_stats();
+
+    memcpy(bench_i2c_memory, source, VL53L5CX_MAX_RESULTS_SIZE);
+    for(int f = 0; f < FRAME_COUNT; f++) {
+        memset(buffer, 0, VL53L5CX_MAX_RESULTS_SIZE);
+        errors += (VL53L5CX_RdMulti(
+            &platform, 0, buffer, VL53L5CX_MAX_RESULTS_SIZE
+        ) != 0);
+
+        if(memcmp(buffer, source, VL53L5CX_MAX_RESULTS_SIZE)) {
+            printf("  [!] frame was not read correctly\n");
+            errors++;
+        }
+    }
+    errors += check_stats();
+
+    print_result("frame", setting, FRAME_COUNT);
+    return errors;
+}
+
+int bench_i2c(void) {
+    int errors = 0;
+
+    srand(1234);
+    for(int i = 0; i < sizeof(source); i++)
+        source[i] = rand();
+
+    printf(
+        "I2C transfers (simulated bus):\n"
+        "  %-9s %7s %5s %10s %10s %10s\n",
+        "workload", "Hz", "chunk", "transfers", "bytes", "bus ms"
+    );
+    for(int s = 0; s < sizeof(settings) / sizeof(settings[0]); s++) {
+        if(vl53l5cx_platform_set_transfer(settings[s].frequency,
+                                          settings[s].chunk_size)) {
+            printf("  [!] transfer settings were rejected\n");
+            errors++;
+            continue;
+        }
+        errors += bench_upload(s);
+        errors += bench_frame_read(s);
+    }
+    printf("  (per upload or frame; chunk 0 = no limit)\n");
+
+    vl53l5cx_platform_set_transfer(400000, 0);
+    return errors;
+}
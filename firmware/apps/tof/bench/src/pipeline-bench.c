@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tof2can.h"
+#include "processing.h"
+#include "can-io.h"
+#include "tof.h"
+
+#define FRAME_COUNT 256
+#define REPETITIONS 16
+
+static struct bench_frame frames[FRAME_COUNT];
+
+#define ENCODING_SAMPLE      0
+#define ENCODING_DATA_PACKET 1
+#define ENCODING_PACKED      2
+#define ENCODING_DELTA       3
+
+static const char *encoding_names[] = {
+    "sample", "data packets", "packed", "delta"
+};
+
+static const char *selector_names[] = {
+    "min", "max", "average", "all", "median", "10th pct"
+};
+
+static const struct {
+    const char *name;
+    int mode; // processing mode, without result selector
+} areas[] = {
+    { "matrix", TOF2CAN_PROCMODE_MIN_IN_MATRIX    },
+    { "column", TOF2CAN_PROCMODE_MIN_IN_COLUMN(1) },
+    { "row",    TOF2CAN_PROCMODE_MIN_IN_ROW(1)    },
+    { "point",  TOF2CAN_PROCMODE_POINT(1, 1)      }
+};
+
+// A slowly approaching slanted surface, with noise. Some zones of the
+// last column are invalid, so that the benchmarked areas other than the
+// matrix only contain valid zones.
+static void generate_frames(int width) {
+    srand(1234);
+    for(int f = 0; f < FRAME_COUNT; f++) {
+        struct bench_frame *frame = &frames[f];
+
+        for(int i = 0; i < width * width; i++) {
+            const int x = i % width;
+            const int y = i / width;
+
+            frame->distance[i] = (
+                2000 - (f % 64) * 8 + x * 25 + y * 15 + rand() % 12
+            );
+            frame->status[i] = (
+                x == width - 1 && rand() % 4 == 0 ? 255 : 5
+            );
+            frame->sigma[i] = 3 + rand() % 5;
+            frame->signal_per_spad[i] = 50 + rand() % 200;
+        }
+    }
+}
+
+static void configure(int area, int selector, int encoding) {
+    quiet_begin();
+    processing_set_mode(0, 0, areas[area].mode);
+    processing_set_selector(0, 0, selector, 10);
+
+    can_io_set_transmit_timing(0, TOF2CAN_TIMING_CONTINUOUS);
+    can_io_set_transmit_condition(0, 0, TOF2CAN_CONDITION_ALWAYS_TRUE);
+    can_io_set_data_encoding(
+        0, encoding == ENCODING_DATA_PACKET ? TOF2CAN_ENCODING_DATA_PACKET
+                                         : TOF2CAN_ENCODING_PACKED_PACKET
+    );
+    can_io_set_delta(0, encoding == ENCODING_DELTA, 20, 10);
+    quiet_end();
+}
+
+static int run(int area, int selector, int encoding) {
+    int errors = 0;
+    configure(area, selector, encoding);
+
+    uint64_t process_ns = 0;
+    uint64_t send_ns    = 0;
+    uint64_t batches    = 0;
+    bench_can_stats = (struct bench_can_stats) { 0 };
+
+    for(int r = 0; r < REPETITIONS; r++) {
+        for(int f = 0; f < FRAME_COUNT; f++) {
+            bench_frame = frames[f];
+
+            const uint64_t can_frames = bench_can_stats.frames;
+            const uint64_t start = get_ns();
+
+            errors += (processing_run(0) != 0);
+            const uint64_t processed = get_ns();
+
+            errors += (bench_can_send() != 0);
+            const uint64_t sent = get_ns();
+
+            process_ns += processed - start;
+            send_ns    += sent - processed;
+            batches    += (bench_can_stats.frames != can_frames);
+        }
+    }
+
+    const int iterations = REPETITIONS * FRAME_COUNT;
+    printf(
+        "  %-7s %-9s %-13s %8.1f %8.1f %8.1f %8.2f\n",
+        areas[area].name, selector_names[selector],
+        encoding_names[encoding],
+        (double) process_ns / iterations,
+        (double) send_ns / iterations,
+        (double) bench_can_stats.bytes / iterations,
+        batches ? (double) bench_can_stats.frames / batches : 0
+    );
+    return errors;
+}
+
+int bench_pipeline(void) {
+    const int resolutions[] = { 16, 64 };
+    int errors = 0;
+
+    // a single sensor is benchmarked
+    processing_init();
+
+    for(int r = 0; r < 2; r++) {
+        quiet_begin();
+        tof_set_resolution(0, resolutions[r]);
+        quiet_end();
+
+        const int width = tof_get_matrix_width(0);
+        generate_frames(width);
+
+        printf(
+            "pipeline, %dx%d:\n"
+            "  %-7s %-9s %-13s %8s %8s %8s %8s\n",
+            width, width,
+            "area", "selector", "encoding",
+            "proc ns", "send ns", "bytes", "frames"
+        );
+
+        for(int area = 0; area < 4; area++) {
+            for(int selector = 0; selector < 6; selector++) {
+                // the 'all' selector is the only one sending batches
+                if(selector != 3) {
+                    errors += run(area, selector, ENCODING_SAMPLE);
+                    continue;
+                }
+
+                // a point is a single sample
+                if(areas[area].mode == TOF2CAN_PROCMODE_POINT(1, 1)) {
+                    errors += run(area, selector, ENCODING_SAMPLE);
+                    continue;
+                }
+
+                errors += run(area, selector, ENCODING_DATA_PACKET);
+                errors += run(area, selector, ENCODING_PACKED);
+                errors += run(area, selector, ENCODING_DELTA);
+            }
+        }
+        printf(
+            "  (ns per frame; data bytes per frame; "
+            "CAN frames per batch)\n"
+        );
+    }
+    return errors;
+}
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include "tof2can.h"
+#include "processing.h"
+#include "can-io.h"
+#include "tof.h"
+#include "main.h"
+
+// largest batch of a channel: a timestamp, then 3 samples per packet
+#define CHANNEL_FRAMES (1 + (PROCESSING_DATA_MAX_LENGTH + 2) / 3)
+
+// Every channel of every sensor sends a full 8x8 matrix, timestamped
+static void configure(void) {
+    quiet_begin();
+    tof_sensor_count = TOF_MAX_SENSORS;
+    tof_set_resolution(0, 64);
+
+    for(int s = 0; s < TOF_MAX_SENSORS; s++) {
+        const int first_id = 1 + s * PROCESSING_CHANNEL_COUNT;
+        can_io_set_sensor_id(s, first_id);
+        can_io_set_transmit_timing(s, TOF2CAN_TIMING_CONTINUOUS);
+        can_io_set_data_encoding(s, TOF2CAN_ENCODING_DATA_PACKET);
+        can_io_set_delta(s, false, 0, 1);
+        can_io_set_timestamps(s, true);
+
+        for(int c = 0; c < PROCESSING_CHANNEL_COUNT; c++) {
+            if(c > 0)
+                can_io_set_channel_id(s, c, first_id + c);
+            processing_set_enabled(s, c, true);
+            processing_set_mode(s, c, TOF2CAN_PROCMODE_MIN_IN_MATRIX);
+            processing_set_selector(s, c, 3, 0); // all
+            can_io_set_transmit_condition(
+                s, c, TOF2CAN_CONDITION_ALWAYS_TRUE
+            );
+        }
+    }
+    quiet_end();
+}
+
+// A flat surface with all zones valid
+static void generate_frame(void) {
+    for(int i = 0; i < 64; i++) {
+        bench_frame.distance[i]        = 1000 + i;
+        bench_frame.status[i]          = 5;
+        bench_frame.sigma[i]           = 4;
+        bench_frame.signal_per_spad[i] = 100;
+    }
+}
+
+int bench_queue(void) {
+    int errors = 0;
+
+    processing_init();
+    bench_can_init();
+    configure();
+    generate_frame();
+
+    const struct can_io_tx_stats before = can_io_tx_stats;
+    bench_can_stats = (struct bench_can_stats) { 0 };
+
+    // while the bus is busy, each sensor queues a frame of data and a
+    // telemetry report
+    bench_can_full = true;
+    for(int s = 0; s < TOF_MAX_SENSORS; s++)
+        errors += (processing_run(s) != 0);
+    errors += (bench_can_send() != 0);
+    for(int s = 0; s < TOF_MAX_SENSORS; s++)
+        bench_can_send_telemetry(s);
+
+    bench_can_full = false;
+    bench_can_flush();
+
+    const int expected_frames = TOF_MAX_SENSORS * (
+        PROCESSING_CHANNEL_COUNT * CHANNEL_FRAMES +
+        TOF2CAN_TELEMETRY_PAGE_COUNT
+    );
+    const int dropped = (
+        can_io_tx_stats.dropped_batches - before.dropped_batches
+    );
+    printf(
+        "queue, all channels of %d sensors while the bus is busy:\n"
+        "  frames written: %d (expected %d)\n"
+        "  batches dropped: %d\n",
+        TOF_MAX_SENSORS, (int) bench_can_stats.frames, expected_frames,
+        dropped
+    );
+    errors += (bench_can_stats.frames != expected_frames);
+    errors += (dropped != 0);
+
+    // back to the single sensor of the other benchmarks
+    tof_sensor_count = 1;
+    return errors;
+}
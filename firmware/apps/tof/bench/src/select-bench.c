@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "selection.h"
+
+#define FRAME_COUNT 1024
+#define REPETITIONS 64
+
+// returns the value selected from the frame
+typedef int (*BenchFunction)(const int16_t *frame, int count);
+
+static int16_t frames[FRAME_COUNT][64];
+static volatile int sink;
+
+#define PATTERN_RANDOM 0
+#define PATTERN_SORTED 1
+#define PATTERN_EQUAL  2
+#define PATTERN_FLYERS 3
+#define PATTERN_COUNT  4
+
+static const char *pattern_names[PATTERN_COUNT] = {
+    "random", "sorted", "equal", "flyers"
+};
+
+static void generate_frames(int pattern, int count) {
+    srand(1234);
+    for(int f = 0; f < FRAME_COUNT; f++) {
+        for(int i = 0; i < count; i++) {
+            int16_t sample = 0;
+            switch(pattern) {
+                case PATTERN_RANDOM:
+                    sample = rand() % 4000;
+                    break;
+
+                case PATTERN_SORTED:
+                    sample = i * 4000 / count;
+                    break;
+
+                case PATTERN_EQUAL:
+                    sample = 1500;
+                    break;
+
+                case PATTERN_FLYERS:
+                    // a flat surface, with some zones reading too close
+                    sample = (rand() % 8 == 0) ? rand() % 100
+                                               : 1500 + rand() % 20;
+                    break;
+            }
+            frames[f][i] = sample;
+        }
+    }
+}
+
+static void run(const char *name, BenchFunction function, int count) {
+    const uint64_t start_ns     = get_ns();
+    const uint64_t start_cycles = get_cycles();
+
+    for(int r = 0; r < REPETITIONS; r++)
+        for(int f = 0; f < FRAME_COUNT; f++)
+            sink = function(frames[f], count);
+
+    const uint64_t ns     = get_ns() - start_ns;
+    const uint64_t cycles = get_cycles() - start_cycles;
+    const int iterations  = REPETITIONS * FRAME_COUNT;
+
+    printf(
+        "  %-20s %8.1f ns/frame %8.1f cycles/frame\n",
+        name,
+        (double) ns / iterations,
+        (double) cycles / iterations
+    );
+}
+
+/* ================================================================== */
+/*                             Selection                              */
+/* ================================================================== */
+
+static int compare_samples(const void *a, const void *b) {
+    return *(const int16_t *) a - *(const int16_t *) b;
+}
+
+// reference implementation: sort a copy of the samples
+static int sort_percentile(const int16_t *samples, int count,
+                           int percentile) {
+    int16_t sorted[64];
+    memcpy(sorted, samples, count * sizeof(int16_t));
+    qsort(sorted, count, sizeof(int16_t), compare_samples);
+
+    int k = (percentile * count + 99) / 100 - 1;
+    if(k < 0)
+        k = 0;
+    return sorted[k];
+}
+
+static int bench_median(const int16_t *frame, int count) {
+    return selection_percentile(frame, count, 50);
+}
+
+static int bench_p10(const int16_t *frame, int count) {
+    return selection_percentile(frame, count, 10);
+}
+
+static int bench_sort_median(const int16_t *frame, int count) {
+    return sort_percentile(frame, count, 50);
+}
+
+static int bench_min(const int16_t *frame, int count) {
+    int min = frame[0];
+    for(int i = 1; i < count; i++)
+        if(min > frame[i])
+            min = frame[i];
+    return min;
+}
+
+static int check_selection(int count) {
+    int errors = 0;
+    for(int f = 0; f < FRAME_COUNT; f++) {
+        for(int p = 0; p <= 100; p++) {
+            const int expected = sort_percentile(frames[f], count, p);
+            const int result = selection_percentile(frames[f], count, p);
+            errors += (result != expected);
+        }
+    }
+    return errors;
+}
+
+int bench_selection(void) {
+    const int counts[] = { 16, 64 };
+    int errors = 0;
+
+    for(int c = 0; c < 2; c++) {
+        const int count = counts[c];
+
+        for(int p = 0; p < PATTERN_COUNT; p++) {
+            generate_frames(p, count);
+            printf(
+                "selection, %d zones, %s samples:\n",
+                count, pattern_names[p]
+            );
+
+            run("min", bench_min, count);
+            run("median", bench_median, count);
+            run("10th percentile", bench_p10, count);
+            run("median (qsort)", bench_sort_median, count);
+
+            const int frame_errors = check_selection(count);
+            printf("  mismatches against qsort: %d\n", frame_errors);
+            errors += frame_errors;
+        }
+    }
+    return errors;
+}
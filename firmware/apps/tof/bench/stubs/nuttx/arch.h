@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-/* Copyright 2026 Rocco Rusponi
+/* Copyright 2025 Rocco Rusponi
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -15,6 +15,20 @@
  * You should have received a copy of the GNU General Public License
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
-#include "sensor.h"
+#pragma once
 
-struct SensorState sensor_states[TOF2CAN_MAX_SENSOR_COUNT];
+// Host replacement of the NuttX performance counter, limited to what
+// the firmware uses. The counter runs at 1 GHz.
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t up_perf_gettime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static inline unsigned long up_perf_getfreq(void) {
+    return 1000000000;
+}
@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-/* Copyright 2026 Rocco Rusponi
+/* Copyright 2025 Rocco Rusponi
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -17,39 +17,33 @@
  */
 #pragma once
 
-#include "main.h"
+// Host replacement of the NuttX CAN character driver interface, limited
+// to what the firmware uses.
 
-#include "tof2can.h"
+#include <stdint.h>
 
-#define SENSOR_DATA_MAX_LENGTH 64
-
-struct SensorData {
-    bool available;
-
-    int     buffer_length;
-    int16_t buffer[SENSOR_DATA_MAX_LENGTH];
-
-    bool below_threshold;
-    bool threshold_event;
+struct can_hdr_s {
+    uint32_t ch_id;
+    uint8_t  ch_dlc   : 4;
+    uint8_t  ch_rtr   : 1;
+    uint8_t  ch_error : 1;
+    uint8_t  ch_extid : 1;
+    uint8_t  ch_tcf   : 1;
+    uint8_t  ch_unused;
 };
 
-struct SensorConfig {
-    int matrix_width;
-
-    struct Bounds { int x0, y0, x1, y1 } bounds;
-    int result_selector;
+struct can_msg_s {
+    struct can_hdr_s cm_hdr;
+    uint8_t cm_data[8];
+};
 
-    int threshold;
-    int threshold_delay;
-    int threshold_focus;
+#define CAN_MSGLEN(nbytes) (sizeof(struct can_hdr_s) + (nbytes))
 
-    int transmit_timing;
-    int transmit_condition;
+struct canioc_bittiming_s {
+    uint32_t bt_baud;
+    uint8_t  bt_sjw;
+    uint8_t  bt_tseg1;
+    uint8_t  bt_tseg2;
 };
 
-struct SensorState {
-    int data_requests;
-
-    struct SensorData   data;
-    struct SensorConfig config;
-} sensor_states[TOF2CAN_MAX_SENSOR_COUNT];
+#define CANIOC_GET_BITTIMING 1
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+// Host replacement of the NuttX I2C master interface, limited to what
+// the firmware uses.
+
+#include <stdint.h>
+
+struct i2c_master_s;
+
+struct i2c_config_s {
+    uint32_t frequency;
+    uint16_t address;
+    uint8_t  addrlen;
+};
+
+extern int i2c_write(struct i2c_master_s *dev,
+                     const struct i2c_config_s *config,
+                     const uint8_t *buffer, int buflen);
+
+// if rbuflen is negative, -rbuflen bytes of rbuffer are written instead
+extern int i2c_writeread(struct i2c_master_s *dev,
+                         const struct i2c_config_s *config,
+                         const uint8_t *wbuffer, int wbuflen,
+                         uint8_t *rbuffer, int rbuflen);
@@ -21,7 +21,76 @@
 
 extern int can_io_init(void);
 extern void can_io_run(void);
+extern int can_io_wait(int timeout_ms);
+extern void can_io_notify(void);
 
-extern int can_io_set_sensor_id(int id);
-extern int can_io_set_transmit_timing(int timing);
-extern int can_io_set_transmit_condition(int condition);
+// Time taken to apply a struct tof2can_config, from its reception
+// until the sensor is ranging again. Changes to sensor settings need
+// ranging to restart and reset the extended settings, while other
+// changes are applied in place, one setting at a time.
+#define CAN_IO_RECONFIG_IN_PLACE 0
+#define CAN_IO_RECONFIG_RESTART  1
+
+struct can_io_reconfig_latency {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+};
+
+struct can_io_reconfig_stats {
+    struct can_io_reconfig_latency latency[2];
+};
+
+extern struct can_io_reconfig_stats can_io_reconfig_stats;
+
+// Messages read from the CAN device. Messages that are not addressed
+// to any sensor should be rejected by the acceptance filters instead.
+struct can_io_rx_stats {
+    uint32_t received;
+    uint32_t ignored;
+    uint32_t overruns; // times the controller's receive FIFO overflowed
+};
+
+extern struct can_io_rx_stats can_io_rx_stats;
+
+// Prints the acceptance filters, as read back from the CAN controller
+extern void can_io_print_filters(void);
+
+// Data messages are queued, then written to the CAN device in whole
+// batches: stale batches are dropped rather than sent in part.
+struct can_io_tx_stats {
+    uint32_t batches;         // batches written entirely
+    uint32_t frames;          // messages written
+    uint32_t dropped_batches;
+    uint32_t dropped_frames;
+    uint32_t late_frames;     // written after the batch deadline
+    uint32_t write_errors;    // writes failing for reasons other than
+                              // the TX FIFO being full
+    uint32_t max_queued_frames;
+    uint32_t beacons;         // beacons setting the transmit slots
+};
+
+extern struct can_io_tx_stats can_io_tx_stats;
+
+extern void can_io_print_tx_stats(void);
+
+// Applies the configuration stored via CAN for each sensor, if any.
+// Returns 1 if none is stored.
+extern int can_io_restore_config(void);
+
+// Each sensor is configured through its own CAN ID, and transmits its
+// channel 0 with it. IDs must be unique among sensors and channels.
+extern int can_io_set_sensor_id(int sensor, int id);
+extern int can_io_set_transmit_timing(int sensor, int timing);
+extern int can_io_set_transmit_condition(int sensor, int channel,
+                                         int condition);
+extern int can_io_set_channel_id(int sensor, int channel, int id);
+extern int can_io_set_data_encoding(int sensor, int encoding);
+extern int can_io_set_delta(int sensor, bool enabled, int deadband,
+                            int keyframe_interval);
+
+// Health reports are sent every 'interval_ms' (0 = disabled)
+extern int can_io_set_telemetry(int sensor, int interval_ms);
+
+// Capture time sent before each sample or batch (disabled by default)
+extern int can_io_set_timestamps(int sensor, bool enabled);
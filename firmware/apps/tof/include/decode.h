@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "main.h"
+
+#include "vl53l5cx_api.h"
+
+#define DECODE_MAX_ELEMENTS \
+    (VL53L5CX_RESOLUTION_8X8 * VL53L5CX_NB_TARGET_PER_ZONE)
+
+// Decoded ranging data, in the same format of VL53L5CX_ResultsData.
+// Arrays hold one element per zone and target.
+struct decode_output {
+    int16_t  distance_mm[DECODE_MAX_ELEMENTS];
+    uint8_t  target_status[DECODE_MAX_ELEMENTS];
+    uint16_t range_sigma_mm[DECODE_MAX_ELEMENTS];
+    uint32_t signal_per_spad[DECODE_MAX_ELEMENTS];
+    uint8_t  nb_target_detected[VL53L5CX_RESOLUTION_8X8];
+};
+
+/*
+ * Decodes a frame read from the sensor, replacing the decoding done by
+ * vl53l5cx_get_ranging_data. Only the blocks stored in 'output' are
+ * decoded: other blocks are skipped, and so are the zones beyond the
+ * given resolution (16 or 64). The buffer is not modified.
+ *
+ * Returns 0 on success, 1 if the frame is corrupted (header and footer
+ * IDs differ, or a block does not fit).
+ */
+extern int decode_frame(const uint8_t *buffer, int size, int resolution,
+                        struct decode_output *output);
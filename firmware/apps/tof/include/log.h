@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "main.h"
+
+// Messages are written to a ring as an event ID and a few arguments,
+// then formatted and printed by a low-priority task, so that the tasks
+// writing them never wait for the console. If the ring is full, the
+// oldest messages are dropped.
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_DEBUG 2
+
+// Events (and their arguments)
+#define LOG_EVENT_NO_VALID_DATA     0 // sensor
+#define LOG_EVENT_READY_CHECK_ERROR 1 // sensor
+#define LOG_EVENT_READ_ERROR        2 // sensor
+#define LOG_EVENT_CORRUPTED_FRAME   3 // sensor
+#define LOG_EVENT_CAN_WRITE_ERROR   4 // CAN ID, errno
+#define LOG_EVENT_DUMP_BEGIN        5 // sensor, channel
+#define LOG_EVENT_DUMP_ROW          6 // zones of a row of the area
+#define LOG_EVENT_DUMP_DATA         7 // up to 8 values of the result
+#define LOG_EVENT_DUMP_THRESHOLD    8 // below threshold, threshold event
+#define LOG_EVENT_COUNT 9
+
+struct log_event_info {
+    int  level;
+    bool list; // if true, the arguments follow the format, comma-separated
+    const char *format; // printf format, taking the arguments as int
+};
+
+extern const struct log_event_info log_events[LOG_EVENT_COUNT];
+
+#define LOG_MAX_ARGS 8
+
+struct log_entry {
+    uint32_t time_ms;
+    uint32_t cycles; // cycle counter, for intervals shorter than 1 ms
+    uint16_t event;
+    uint8_t  nargs;
+    int16_t  args[LOG_MAX_ARGS];
+};
+
+// Writes the text of an event to a buffer, returning its length as
+// snprintf does. Also compiled into the host formatter.
+extern int log_format(char *buffer, int size, int event,
+                      const int16_t *args, int nargs);
+
+// Events above this level are not written
+extern volatile int log_level;
+
+static inline bool log_enabled(int level) {
+    return level <= log_level;
+}
+
+extern int log_init(void);
+
+// Can be called by any task, but not from interrupt handlers
+extern void log_write(int event, const int16_t *args, int nargs);
+
+#define LOG(event, ...) do {                                            \
+    const int16_t log_args_[] = { __VA_ARGS__ };                        \
+    log_write(event, log_args_, sizeof(log_args_) / sizeof(int16_t));   \
+} while(0)
+
+// Messages are printed as text (default), printed as raw records for
+// the host formatter, or held in the ring until dumped
+#define LOG_OUTPUT_TEXT 0
+#define LOG_OUTPUT_RAW  1
+#define LOG_OUTPUT_HOLD 2
+
+extern void log_set_output(int output);
+
+// Prints the messages held in the ring
+extern void log_dump(void);
+
+extern void log_print_stats(void);
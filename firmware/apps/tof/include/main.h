@@ -25,4 +25,8 @@
 #define BOARD_GREEN_LED 1
 extern void board_userled(int led, bool ledon);
 
-extern bool debug_flag;
+// VL53L5CX sensors that the board can drive, each with its own LPn pin
+#define TOF_MAX_SENSORS 4
+
+// iterations of the main loop since boot
+extern volatile uint32_t main_loop_count;
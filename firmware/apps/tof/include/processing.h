@@ -21,17 +21,59 @@
 
 #define PROCESSING_DATA_MAX_LENGTH 64
 
-extern void processing_run(void);
+// number of channels processing the same ToF frame
+#define PROCESSING_CHANNEL_COUNT 4
 
-extern void processing_pause(void);
-extern void processing_resume(void);
+struct processing_data {
+    bool available; // false if disabled or without valid data points
 
-extern int processing_get_data(int16_t *buffer,
-                               int *length,
-                               bool *below_threshold,
-                               bool *threshold_event);
+    int     buffer_length;
+    int16_t buffer[PROCESSING_DATA_MAX_LENGTH];
 
-extern int processing_set_mode(int mode);
-extern int processing_set_threshold(int threshold);
-extern int processing_set_threshold_delay(int delay);
-extern int processing_set_threshold_focus(int focus);
+    bool below_threshold;
+    bool threshold_event;
+};
+
+struct processing_frame {
+    struct processing_data channels[PROCESSING_CHANNEL_COUNT];
+
+    uint32_t captured; // cycle counter when the frame was captured
+};
+
+// Each sensor has its own processing state, selected by its index in
+// the order sensors were booted (see 'tof_init').
+extern void processing_init(void);
+
+extern int processing_run(int sensor);
+
+// Frames read from each sensor since boot
+extern uint32_t processing_frames_acquired[TOF_MAX_SENSORS];
+
+extern void processing_pause(int sensor);
+extern void processing_resume(int sensor);
+
+// Data is handed over through a pair of swapped buffers: the buffer
+// returned by 'processing_acquire_data' is not written until it is given
+// back by calling 'processing_release_data'.
+extern const struct processing_frame *processing_acquire_data(int sensor);
+extern void processing_release_data(int sensor);
+
+extern int processing_set_enabled(int sensor, int channel, bool enabled);
+extern int processing_set_mode(int sensor, int channel, int mode);
+extern int processing_set_area(int sensor, int channel,
+                               int x0, int y0, int x1, int y1,
+                               int selector);
+extern int processing_set_selector(int sensor, int channel, int selector,
+                                   int percentile);
+extern int processing_set_filter(int sensor, int accepted_statuses,
+                                 int max_sigma, int min_signal);
+extern int processing_set_temporal_filter(int sensor, int mode,
+                                          int weight, int length);
+extern int processing_set_targets(int sensor, int policy,
+                                  int secondary_channels);
+extern int processing_set_threshold(int sensor, int channel,
+                                    int threshold);
+extern int processing_set_threshold_delay(int sensor, int channel,
+                                          int delay);
+extern int processing_set_threshold_focus(int sensor, int channel,
+                                          int focus);
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "main.h"
+
+// samples are saturated to this value while being selected
+#define SELECTION_MAX_VALUE 4095
+
+// maximum number of samples that can be selected from
+#define SELECTION_MAX_COUNT 255
+
+/*
+ * Returns the k-th smallest sample (k = 0 is the minimum), without
+ * modifying the samples. Negative samples are treated as 0. There must
+ * be at least one sample, and k must be less than the sample count.
+ *
+ * The running time only depends on the number of samples: the samples
+ * are scanned exactly twice, plus two scans of 64 counters.
+ */
+extern int selection_kth(const int16_t *samples, int count, int k);
+
+/*
+ * Returns the given percentile (0...100) of the samples, using the
+ * nearest-rank method. The median is the 50th percentile: for an even
+ * number of samples, the lower of the two middle samples is returned.
+ */
+extern int selection_percentile(const int16_t *samples, int count,
+                                int percentile);
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "main.h"
+
+// Records kept in the last pages of the MCU's flash, which the linker
+// script leaves free. Each key has its own page, and each sensor its
+// own keys.
+#define STORAGE_KEY_OFFSET_DATA(sensor) (sensor) // read from sensor's NVM
+#define STORAGE_KEY_CONFIG(sensor) \
+    (TOF_MAX_SENSORS + (sensor)) // last configuration received via CAN
+
+#define STORAGE_KEY_COUNT (2 * TOF_MAX_SENSORS)
+
+/*
+ * Reads the record of the given key, which must be exactly 'size'
+ * bytes long. Returns 0 on success, 1 if the record is missing, has a
+ * different size or is corrupted.
+ */
+extern int storage_read(int key, void *data, int size);
+
+/*
+ * Replaces the record of the given key. Erasing and writing the flash
+ * stalls the CPU for tens of milliseconds.
+ */
+extern int storage_write(int key, const void *data, int size);
+
+extern int storage_erase(int key);
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "main.h"
+
+// Bus time follows the clock of the user device, in microseconds, as
+// broadcast in struct tof2can_sync. Between sync messages, it is
+// counted with the cycle counter, whose rate is measured against the
+// sync messages to compensate the drift of the oscillator. Until the
+// first sync message, bus time counts from boot.
+
+// Called when a sync message is received, with the cycle counter read
+// at reception
+extern void sync_handle(uint64_t host_us, uint32_t cycles);
+
+// Converts a value of the cycle counter, read in the last few seconds,
+// to bus time. Returns true if bus time follows the user device.
+extern bool sync_get_time(uint32_t cycles, uint64_t *time_us);
+
+extern void sync_print(void);
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "main.h"
+
+#define TIMING_STAGE_ACQUIRE  0 // I2C readout and processing
+#define TIMING_STAGE_TRANSMIT 1 // CAN writes
+#define TIMING_STAGE_COUNT    2
+
+extern void timing_begin(int stage);
+extern void timing_end(int stage, bool completed);
+
+extern void timing_print(void);
+extern void timing_reset(void);
+
+// Cycle profile of the steps of each frame, measured with the DWT cycle
+// counter. Each profile is only updated by one thread, without locks:
+// readers retry until they get a consistent copy.
+#define TIMING_PROFILE_READ      0 // tof_read_data: ready check, I2C, decode
+#define TIMING_PROFILE_PROCESS   1 // process_matrix, once per channel
+#define TIMING_PROFILE_THRESHOLD 2 // update_threshold_status
+#define TIMING_PROFILE_WRITE     3 // encoding and writing CAN messages
+#define TIMING_PROFILE_COUNT     4
+
+// Bucket N counts durations of [2^(N+7), 2^(N+8)) cycles. The first and
+// last buckets also count shorter and longer durations.
+#define TIMING_HISTOGRAM_BUCKETS 16
+
+struct timing_profile {
+    uint32_t count;
+    uint32_t min, max; // cycles
+    uint64_t total;    // cycles
+    uint32_t histogram[TIMING_HISTOGRAM_BUCKETS];
+};
+
+// Returns the start time to be passed to 'timing_profile_end'
+extern uint32_t timing_profile_begin(void);
+extern void timing_profile_end(int profile, uint32_t start);
+
+extern void timing_profile_read(int profile, struct timing_profile *data);
+extern void timing_profile_print(void);
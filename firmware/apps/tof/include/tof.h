@@ -19,15 +19,105 @@
 
 #include "main.h"
 
-extern int tof_matrix_width; // width = height = sqrt(resolution)
+// Sensors are numbered from 0 to tof_sensor_count - 1, in the order of
+// their LPn pins. Each has its own I2C address, assigned by tof_init.
+extern int tof_sensor_count;
 
-extern int tof_init(void);
+extern int tof_init(int count);
 
-extern void tof_start_ranging(void);
-extern void tof_stop_ranging(void);
+// width = height = sqrt(resolution)
+extern int tof_get_matrix_width(int sensor);
 
-extern int tof_read_data(int16_t **matrix, uint8_t **status_matrix);
+// Phases of tof_init. Reboot, upload and calibration are skipped if the
+// sensor's firmware is still running from before the MCU reset (warm
+// boot); the offset data read from the sensor's NVM is cached in flash.
+#define TOF_BOOT_PHASE_RESET         0 // reset and I2C reset pins
+#define TOF_BOOT_PHASE_DETECT        1 // check if the sensor answers
+#define TOF_BOOT_PHASE_WARM_CHECK    2 // check if the firmware is running
+#define TOF_BOOT_PHASE_REBOOT        3 // sensor software reboot
+#define TOF_BOOT_PHASE_UPLOAD        4 // firmware upload
+#define TOF_BOOT_PHASE_CALIBRATION   5 // offset and crosstalk data
+#define TOF_BOOT_PHASE_CONFIGURATION 6 // default configuration
+#define TOF_BOOT_PHASE_SETUP         7 // ranging mode, resolution
+#define TOF_BOOT_PHASE_COUNT 8
 
-extern int tof_set_resolution(int resolution);
-extern int tof_set_frequency(int frequency_hz);
-extern int tof_set_sharpener(int sharpener_percent);
+struct tof_boot_stats {
+    bool warm;          // firmware was still running
+    bool offset_cached; // offset data was found in flash
+    uint32_t phase_ms[TOF_BOOT_PHASE_COUNT];
+    uint32_t total_ms;
+};
+extern struct tof_boot_stats tof_boot_stats;
+
+// Drops the cached offset data: needed if a sensor is replaced
+extern int tof_clear_boot_cache(void);
+
+// I2C frequency of the firmware upload, e.g. 1000000 (Fast-mode Plus) if
+// the bus allows it; 0 (default) keeps the one set by tof_set_i2c. If the
+// upload fails at this frequency, it is retried at the configured one.
+extern int tof_set_boot_i2c(int frequency);
+
+extern void tof_start_ranging(int sensor);
+extern void tof_stop_ranging(int sensor);
+
+// Optional outputs read with each frame, besides distance and status.
+// Fewer outputs make each frame's I2C transaction shorter.
+#define TOF_OUTPUT_SIGMA  (1 << 0)
+#define TOF_OUTPUT_SIGNAL (1 << 1)
+#define TOF_OUTPUT_PROFILE_COUNT 4 // combinations of the bits above
+
+// The output profile is applied when ranging starts
+extern int tof_set_outputs(int sensor, int outputs);
+extern int tof_get_outputs(int sensor);
+
+// Bytes read from the sensor per frame, with the given outputs
+extern int tof_get_frame_size(int sensor, int outputs);
+
+// Per-zone data of every target, in row-major order. The targets of
+// zone Z are at indices [Z * stride, Z * stride + nb_targets[Z]).
+// Sigma and signal are only updated if enabled in the output profile.
+// The frame was captured at cycle counter 'captured': when the
+// data-ready interrupt was received if enabled, otherwise when the read
+// started.
+struct tof_data {
+    int stride; // targets per zone
+    uint32_t captured;
+
+    int16_t  *distance;        // mm
+    uint8_t  *status;          // target status (5 and 9 are valid)
+    uint16_t *sigma;           // estimated range error, mm
+    uint32_t *signal_per_spad; // return signal, kcps/SPAD
+    uint8_t  *nb_targets;      // targets detected in each zone
+};
+
+extern int tof_read_data(int sensor, struct tof_data *data);
+
+// Data-ready interrupt (VL53L5CX INT pin, shared by all sensors). With
+// more than one sensor, an interrupt makes tof_read_data check each
+// sensor once.
+extern int tof_interrupt_enable(bool enable);
+extern bool tof_interrupt_pending(void);
+
+struct tof_stats {
+    uint32_t ready_checks;  // calls to vl53l5cx_check_data_ready
+    uint32_t ready_misses;  // ...of which found no new data
+    uint32_t interrupts;    // data-ready interrupts received
+    uint32_t frames;        // frames read from the sensor
+
+    // I2C traffic of the last frame read
+    uint32_t frame_i2c_transactions;
+    uint32_t frame_i2c_bytes;
+};
+extern struct tof_stats tof_stats;
+
+// Failed I2C transfers since boot, on the bus shared by all sensors
+extern uint32_t tof_get_i2c_errors(void);
+
+// I2C bytes transferred by one vl53l5cx_check_data_ready call:
+// 2 register address bytes + 4 data bytes
+#define TOF_READY_CHECK_I2C_BYTES 6
+
+extern int tof_set_resolution(int sensor, int resolution);
+extern int tof_set_frequency(int sensor, int frequency_hz);
+extern int tof_set_sharpener(int sensor, int sharpener_percent);
+extern int tof_set_i2c(int frequency, int chunk_size);
@@ -33,8 +33,40 @@ typedef struct
 	/* Example for most standard platform : I2C address of sensor */
     uint16_t  			address;
 
+	/* Output blocks enabled when ranging starts, as a mask of the
+	 * VL53L5CX_OUTPUT_* bits below (0 = all outputs enabled in this
+	 * file). Outputs disabled in this file stay disabled. */
+    uint32_t			output_enable;
+
+	/* If not 0, vl53l5cx_init uses the offset data already stored in the
+	 * configuration instead of reading it from the sensor's NVM */
+    uint8_t			offset_data_valid;
+
+	/* Optional, called by vl53l5cx_init when each of the
+	 * VL53L5CX_BOOT_STEP_* steps below starts */
+    void			(*boot_step)(uint8_t step);
+
 } VL53L5CX_Platform;
 
+#define VL53L5CX_BOOT_STEP_REBOOT			((uint8_t)0U)
+#define VL53L5CX_BOOT_STEP_UPLOAD			((uint8_t)1U)
+#define VL53L5CX_BOOT_STEP_CALIBRATION		((uint8_t)2U)
+#define VL53L5CX_BOOT_STEP_CONFIGURATION	((uint8_t)3U)
+
+/*
+ * Bits of the output enable mask. Metadata and common data are always
+ * enabled.
+ */
+#define VL53L5CX_OUTPUT_AMBIENT_PER_SPAD	((uint32_t)1U << 3)
+#define VL53L5CX_OUTPUT_NB_SPADS_ENABLED	((uint32_t)1U << 4)
+#define VL53L5CX_OUTPUT_NB_TARGET_DETECTED	((uint32_t)1U << 5)
+#define VL53L5CX_OUTPUT_SIGNAL_PER_SPAD		((uint32_t)1U << 6)
+#define VL53L5CX_OUTPUT_RANGE_SIGMA_MM		((uint32_t)1U << 7)
+#define VL53L5CX_OUTPUT_DISTANCE_MM			((uint32_t)1U << 8)
+#define VL53L5CX_OUTPUT_REFLECTANCE_PERCENT	((uint32_t)1U << 9)
+#define VL53L5CX_OUTPUT_TARGET_STATUS		((uint32_t)1U << 10)
+#define VL53L5CX_OUTPUT_MOTION_INDICATOR	((uint32_t)1U << 11)
+
 /*
  * @brief The macro below is used to define the number of target per zone sent
  * through I2C. This value can be changed by user, in order to tune I2C
@@ -42,7 +74,7 @@ typedef struct
  * zone means a lower RAM). The value must be between 1 and 4.
  */
 
-#define 	VL53L5CX_NB_TARGET_PER_ZONE		1U
+#define 	VL53L5CX_NB_TARGET_PER_ZONE		2U
 
 /*
  * @brief The macro below can be used to avoid data conversion into the driver.
@@ -62,8 +94,8 @@ typedef struct
 #define VL53L5CX_DISABLE_AMBIENT_PER_SPAD
 #define VL53L5CX_DISABLE_NB_SPADS_ENABLED
 // #define VL53L5CX_DISABLE_NB_TARGET_DETECTED
-#define VL53L5CX_DISABLE_SIGNAL_PER_SPAD
-#define VL53L5CX_DISABLE_RANGE_SIGMA_MM
+// #define VL53L5CX_DISABLE_SIGNAL_PER_SPAD
+// #define VL53L5CX_DISABLE_RANGE_SIGMA_MM
 // #define VL53L5CX_DISABLE_DISTANCE_MM
 #define VL53L5CX_DISABLE_REFLECTANCE_PERCENT
 // #define VL53L5CX_DISABLE_TARGET_STATUS
@@ -164,4 +196,23 @@ uint8_t VL53L5CX_WaitMs(
 		VL53L5CX_Platform *p_platform,
 		uint32_t TimeMs);
 
+/*
+ * Sets the I2C bus frequency, up to 1MHz (Fast-mode Plus), and the
+ * maximum number of data bytes per I2C transaction (0 = no limit). By
+ * default, the frequency is 400KHz and there is no limit.
+ */
+int vl53l5cx_platform_set_transfer(uint32_t frequency, uint32_t chunk_size);
+
+/*
+ * I2C traffic generated by the platform functions above. Each
+ * transaction carries a 2-byte register address plus data bytes.
+ */
+struct vl53l5cx_i2c_stats {
+	uint32_t calls;        // platform functions called
+	uint32_t transactions; // I2C transactions
+	uint32_t bytes;        // bytes transferred, including addresses
+	uint32_t errors;       // transactions that failed
+};
+extern struct vl53l5cx_i2c_stats vl53l5cx_i2c_stats;
+
 #endif	// _PLATFORM_H_
@@ -18,26 +18,75 @@
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-#define I2C_FREQUENCY 400000 // 400 KHz
-#define I2C_MAX_PACKET_SIZE 32
+#define I2C_DEFAULT_FREQUENCY 400000  // 400 KHz, Fast-mode
+#define I2C_MAX_FREQUENCY     1000000 // 1 MHz, Fast-mode Plus
+
+// bytes of the register address, sent at the start of each transaction
+#define I2C_ADDRESS_SIZE 2
 
 extern struct i2c_master_s *i2cmain;
 
+static uint32_t i2c_frequency  = I2C_DEFAULT_FREQUENCY;
+static uint32_t i2c_chunk_size = 0; // 0 = no limit
+
+struct vl53l5cx_i2c_stats vl53l5cx_i2c_stats;
+
+static inline void init_config(VL53L5CX_Platform *p_platform,
+                               struct i2c_config_s *config)
+{
+    config->frequency = i2c_frequency;
+    config->address   = (p_platform->address >> 1);
+    config->addrlen   = 7;
+
+    vl53l5cx_i2c_stats.calls++;
+}
+
+static inline void count_transaction(uint32_t data_bytes)
+{
+    vl53l5cx_i2c_stats.transactions++;
+    vl53l5cx_i2c_stats.bytes += I2C_ADDRESS_SIZE + data_bytes;
+}
+
+static inline int count_result(int err)
+{
+    if(err)
+        vl53l5cx_i2c_stats.errors++;
+    return err;
+}
+
+static inline uint32_t get_chunk_size(uint32_t size)
+{
+    if(i2c_chunk_size == 0)
+        return size;
+    return MIN(size, i2c_chunk_size);
+}
+
+int vl53l5cx_platform_set_transfer(uint32_t frequency, uint32_t chunk_size)
+{
+    if(frequency == 0 || frequency > I2C_MAX_FREQUENCY)
+        return 1;
+
+    i2c_frequency  = frequency;
+    i2c_chunk_size = chunk_size;
+    return 0;
+}
+
 uint8_t VL53L5CX_RdByte(
         VL53L5CX_Platform *p_platform,
         uint16_t RegisterAdress,
         uint8_t *p_value)
 {
     struct i2c_config_s config;
-    config.frequency = I2C_FREQUENCY;
-    config.address   = (p_platform->address >> 1);
-    config.addrlen   = 7;
+    init_config(p_platform, &config);
 
-    uint8_t buf[2];
+    uint8_t buf[I2C_ADDRESS_SIZE];
     buf[0] = (RegisterAdress >> 8) & 0xff;
     buf[1] = (RegisterAdress)      & 0xff;
 
-    return i2c_writeread(i2cmain, &config, buf, 2, p_value, 1);
+    count_transaction(1);
+    return count_result(
+        i2c_writeread(i2cmain, &config, buf, I2C_ADDRESS_SIZE, p_value, 1)
+    );
 }
 
 uint8_t VL53L5CX_WrByte(
@@ -46,16 +95,17 @@ uint8_t VL53L5CX_WrByte(
         uint8_t value)
 {
     struct i2c_config_s config;
-    config.frequency = I2C_FREQUENCY;
-    config.address   = (p_platform->address >> 1);
-    config.addrlen   = 7;
+    init_config(p_platform, &config);
 
-    uint8_t buf[3];
+    uint8_t buf[I2C_ADDRESS_SIZE + 1];
     buf[0] = (RegisterAdress >> 8) & 0xff;
     buf[1] = (RegisterAdress)      & 0xff;
     buf[2] = value;
 
-    return i2c_write(i2cmain, &config, buf, 3);
+    count_transaction(1);
+    return count_result(
+        i2c_write(i2cmain, &config, buf, I2C_ADDRESS_SIZE + 1)
+    );
 }
 
 uint8_t VL53L5CX_WrMulti(
@@ -67,20 +117,21 @@ uint8_t VL53L5CX_WrMulti(
     int err = 0;
 
     struct i2c_config_s config;
-    config.frequency = I2C_FREQUENCY;
-    config.address   = (p_platform->address >> 1);
-    config.addrlen   = 7;
+    init_config(p_platform, &config);
 
-    // write in blocks of I2C_MAX_PACKET_SIZE bytes or less
+    // write in chunks of i2c_chunk_size bytes or less
     while(size > 0 && !err) {
-        // write register address
-        uint8_t buf[I2C_MAX_PACKET_SIZE];
+        uint8_t buf[I2C_ADDRESS_SIZE];
         buf[0] = (RegisterAdress >> 8) & 0xff;
         buf[1] = (RegisterAdress)      & 0xff;
 
-        const int data_bytes = MIN(size, I2C_MAX_PACKET_SIZE - 2);
-        memcpy(buf + 2, p_values, data_bytes);
-        err = i2c_write(i2cmain, &config, buf, data_bytes + 2);
+        // write register address, then data without a repeated start
+        // (a negative read length makes i2c_writeread write instead)
+        const int data_bytes = get_chunk_size(size);
+        count_transaction(data_bytes);
+        err = count_result(i2c_writeread(
+            i2cmain, &config, buf, I2C_ADDRESS_SIZE, p_values, -data_bytes
+        ));
 
         size           -= data_bytes; // reduce count of bytes to write
         p_values       += data_bytes; // move data pointer forward
@@ -98,19 +149,20 @@ uint8_t VL53L5CX_RdMulti(
     int err = 0;
 
     struct i2c_config_s config;
-    config.frequency = I2C_FREQUENCY;
-    config.address   = (p_platform->address >> 1);
-    config.addrlen   = 7;
+    init_config(p_platform, &config);
 
-    // read in blocks of I2C_MAX_PACKET_SIZE bytes or less
+    // read in chunks of i2c_chunk_size bytes or less
     while(size > 0 && !err) {
         // write register address
-        uint8_t buf[2];
+        uint8_t buf[I2C_ADDRESS_SIZE];
         buf[0] = (RegisterAdress >> 8) & 0xff;
         buf[1] = (RegisterAdress)      & 0xff;
 
-        const int data_bytes = MIN(size, I2C_MAX_PACKET_SIZE - 2);
-        err = i2c_writeread(i2cmain, &config, buf, 2, p_values, data_bytes);
+        const int data_bytes = get_chunk_size(size);
+        count_transaction(data_bytes);
+        err = count_result(i2c_writeread(
+            i2cmain, &config, buf, I2C_ADDRESS_SIZE, p_values, data_bytes
+        ));
 
         size           -= data_bytes; // reduce count of bytes to write
         p_values       += data_bytes; // move data pointer forward
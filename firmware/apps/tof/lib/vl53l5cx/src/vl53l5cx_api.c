@@ -34,7 +34,6 @@ static uint8_t _vl53l5cx_poll_for_answer(
 	do {
 		status |= VL53L5CX_RdMulti(&(p_dev->platform), address,
 				p_dev->temp_buffer, size);
-		status |= VL53L5CX_WaitMs(&(p_dev->platform), 10);
 
 		if(timeout >= (uint8_t)200)	/* 2s timeout */
 		{
@@ -50,6 +49,12 @@ static uint8_t _vl53l5cx_poll_for_answer(
 		{
 			timeout++;
 		}
+
+		/* Only wait if the answer is not available yet */
+		if((p_dev->temp_buffer[pos] & mask) != expected_value)
+		{
+			status |= VL53L5CX_WaitMs(&(p_dev->platform), 10);
+		}
 	}while ((p_dev->temp_buffer[pos] & mask) != expected_value);
 
 	return status;
@@ -89,6 +94,20 @@ static uint8_t _vl53l5cx_poll_for_mcu_boot(
  * to set the offset data gathered from NVM.
  */
 
+/*
+ * Inner function, not available outside this file. This function tells
+ * the platform which step of the initialization is starting.
+ */
+static void _vl53l5cx_boot_step(
+		VL53L5CX_Configuration		*p_dev,
+		uint8_t				step)
+{
+	if(p_dev->platform.boot_step != NULL)
+	{
+		p_dev->platform.boot_step(step);
+	}
+}
+
 static uint8_t _vl53l5cx_send_offset_data(
 		VL53L5CX_Configuration		*p_dev,
 		uint8_t						resolution)
@@ -250,6 +269,7 @@ uint8_t vl53l5cx_init(
 	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
 
 	/* SW reboot sequence */
+	_vl53l5cx_boot_step(p_dev, VL53L5CX_BOOT_STEP_REBOOT);
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x0009, 0x04);
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x000F, 0x40);
@@ -318,6 +338,7 @@ uint8_t vl53l5cx_init(
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x20, 0x06);
 
 	/* Download FW into VL53L5 */
+	_vl53l5cx_boot_step(p_dev, VL53L5CX_BOOT_STEP_UPLOAD);
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x7fff, 0x09);
 	status |= VL53L5CX_WrMulti(&(p_dev->platform),0,
 		(uint8_t*)&VL53L5CX_FIRMWARE[0],0x8000);
@@ -359,15 +380,23 @@ uint8_t vl53l5cx_init(
 
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
 
-	/* Get offset NVM data and store them into the offset buffer */
-	status |= VL53L5CX_WrMulti(&(p_dev->platform), 0x2fd8,
-		(uint8_t*)VL53L5CX_GET_NVM_CMD, sizeof(VL53L5CX_GET_NVM_CMD));
-	status |= _vl53l5cx_poll_for_answer(p_dev, 4, 0,
-		VL53L5CX_UI_CMD_STATUS, 0xff, 2);
-	status |= VL53L5CX_RdMulti(&(p_dev->platform), VL53L5CX_UI_CMD_START,
-		p_dev->temp_buffer, VL53L5CX_NVM_DATA_SIZE);
-	(void)memcpy(p_dev->offset_data, p_dev->temp_buffer,
-		VL53L5CX_OFFSET_BUFFER_SIZE);
+	/* Get offset NVM data and store them into the offset buffer, unless
+	 * the platform already provided them (e.g. cached from a previous
+	 * boot) */
+	_vl53l5cx_boot_step(p_dev, VL53L5CX_BOOT_STEP_CALIBRATION);
+	if(p_dev->platform.offset_data_valid == (uint8_t)0)
+	{
+		status |= VL53L5CX_WrMulti(&(p_dev->platform), 0x2fd8,
+			(uint8_t*)VL53L5CX_GET_NVM_CMD,
+			sizeof(VL53L5CX_GET_NVM_CMD));
+		status |= _vl53l5cx_poll_for_answer(p_dev, 4, 0,
+			VL53L5CX_UI_CMD_STATUS, 0xff, 2);
+		status |= VL53L5CX_RdMulti(&(p_dev->platform),
+			VL53L5CX_UI_CMD_START, p_dev->temp_buffer,
+			VL53L5CX_NVM_DATA_SIZE);
+		(void)memcpy(p_dev->offset_data, p_dev->temp_buffer,
+			VL53L5CX_OFFSET_BUFFER_SIZE);
+	}
 	status |= _vl53l5cx_send_offset_data(p_dev, VL53L5CX_RESOLUTION_4X4);
 
 	/* Set default Xtalk shape. Send Xtalk to sensor */
@@ -376,6 +405,7 @@ uint8_t vl53l5cx_init(
 	status |= _vl53l5cx_send_xtalk_data(p_dev, VL53L5CX_RESOLUTION_4X4);
 
 	/* Send default configuration to VL53L5CX firmware */
+	_vl53l5cx_boot_step(p_dev, VL53L5CX_BOOT_STEP_CONFIGURATION);
 	status |= VL53L5CX_WrMulti(&(p_dev->platform), 0x2c34,
 		p_dev->default_configuration,
 		sizeof(VL53L5CX_DEFAULT_CONFIGURATION));
@@ -548,6 +578,13 @@ uint8_t vl53l5cx_start_ranging(
 	output_bh_enable[0] += (uint32_t)2048;
 #endif
 
+	/* Disable outputs not selected at runtime in the platform */
+	if(p_dev->platform.output_enable != (uint32_t)0)
+	{
+		output_bh_enable[0] &= (p_dev->platform.output_enable
+                                        | (uint32_t)0x7U);
+	}
+
 	/* Update data size */
 	for (i = 0; i < (uint32_t)(sizeof(output)/sizeof(uint32_t)); i++)
 	{
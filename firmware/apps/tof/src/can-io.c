@@ -19,22 +19,464 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <sys/ioctl.h>
+#include <nuttx/arch.h>
 #include <nuttx/can/can.h>
 
 #include "tof2can.h"
 #include "processing.h"
 #include "tof.h"
+#include "timing.h"
+#include "storage.h"
+#include "log.h"
+#include "sync.h"
+
+#define SENDER_STACK_SIZE 2048
 
 static int can_fd;
-static int sensor_id;
 
-static int transmit_timing;
-static int transmit_condition;
+struct can_io_reconfig_stats can_io_reconfig_stats;
+struct can_io_rx_stats can_io_rx_stats;
+struct can_io_tx_stats can_io_tx_stats;
+
+#define DELTA_BITMAP_WORDS ((PROCESSING_DATA_MAX_LENGTH + 11) / 12)
+
+// Transmission state of each processing channel. Channel 0 transmits
+// using the sensor ID, other channels using their own ID.
+struct channel {
+    int id; // 0 if the channel is disabled
+    int transmit_condition;
+    int data_requests;
+
+    // ID of the last batch sent, in either encoding: the receiver tells
+    // batches apart by their ID and this one, truncated to 5 bits
+    int batch_id;
+
+    // last transmitted value of each zone, as seen by the receiver
+    struct {
+        uint16_t values[PROCESSING_DATA_MAX_LENGTH];
+        int  length;
+        bool valid;
+        int  batches_since_keyframe;
+    } reference;
+};
+
+// Configuration accepted since the last struct tof2can_config, in the
+// order it was received. It can be stored in flash and applied again
+// at boot. Extended settings replace earlier ones with the same key
+// and channel.
+#define STORED_EXT_CONFIG_MAX 24
+struct stored_config {
+    struct tof2can_config config;
+    bool    valid;
+    uint8_t ext_count;
+    char _padding[2];
+
+    struct tof2can_ext_config ext[STORED_EXT_CONFIG_MAX];
+};
+
+// CAN state of each sensor, which is configured through its own ID
+static struct sensor {
+    int index;
+    int id;
+
+    int transmit_timing;
+    int data_encoding;
+
+    // change-only (delta) transmission
+    struct {
+        bool enabled;
+        int  deadband;
+        int  keyframe_interval;
+    } delta;
+
+    struct channel channels[PROCESSING_CHANNEL_COUNT];
+    struct stored_config current_config;
+
+    // capture time sent before each sample or batch
+    bool timestamps;
+
+    // periodic health reports
+    struct {
+        int      interval_ms; // 0 = disabled
+        uint32_t next_ms;
+        uint8_t  sequence;
+
+        uint32_t last_ms;
+        uint32_t last_loop_count;
+
+        uint32_t frames_sent;
+        uint32_t frames_suppressed;
+    } telemetry;
+} sensors[TOF_MAX_SENSORS];
+
+static pthread_mutex_t data_requests_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Held by the sender while it transmits a frame, and by the setters of
+// the transmission settings (IDs, timing, conditions, encoding, delta,
+// telemetry), which other tasks call: each frame is sent with one set
+// of settings, and the sender never undoes a change to its state. Also
+// held while replies to requests are queued.
+static pthread_mutex_t transmit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t get_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// posted when the sender may have something to do
+static sem_t sender_sem;
+
+// Replies to requests go through the transmit queue, like batches: the
+// messages staged between begin_reply and end_reply are written by the
+// sender, in order (see below)
+static void begin_reply(int msg_type, int id);
+static void stage_reply(const void *data, int datalen);
+static void end_reply(void);
+
+/* ================================================================== */
+/*                              Storage                               */
+/* ================================================================== */
+
+static void handle_storage(struct sensor *s, int command) {
+    static struct stored_config stored; // sent back by a read
+
+    int err = 0;
+    int count = 0;
+
+    switch(command) {
+        case TOF2CAN_STORAGE_SAVE:
+            if(s->current_config.valid) {
+                err = storage_write(
+                    STORAGE_KEY_CONFIG(s->index),
+                    &s->current_config, sizeof(s->current_config)
+                );
+            } else {
+                err = 1;
+            }
+            printf(
+                "[CAN-IO] saving configuration of sensor %d (err=%d)\n",
+                s->index, err
+            );
+            break;
+
+        case TOF2CAN_STORAGE_CLEAR:
+            err = storage_erase(STORAGE_KEY_CONFIG(s->index));
+            printf(
+                "[CAN-IO] clearing stored configuration of sensor %d "
+                "(err=%d)\n",
+                s->index, err
+            );
+            break;
+
+        case TOF2CAN_STORAGE_READ:
+            err = storage_read(
+                STORAGE_KEY_CONFIG(s->index), &stored, sizeof(stored)
+            );
+            count = (err ? 0 : 1 + stored.ext_count);
+            break;
+
+        default:
+            printf("[CAN-IO] unknown storage command %d\n", command);
+            err = 1;
+            break;
+    }
+
+    const struct tof2can_storage reply = {
+        .command  = command,
+        .is_reply = true,
+        .error    = err,
+        .count    = count
+    };
+
+    // the stored messages come first, then the reply counting them
+    begin_reply(TOF2CAN_STORAGE_MASK_ID, s->id);
+    if(count > 0) {
+        stage_reply(&stored.config, TOF2CAN_CONFIG_SIZE);
+        for(int i = 0; i < stored.ext_count; i++)
+            stage_reply(&stored.ext[i], TOF2CAN_EXT_CONFIG_SIZE);
+    }
+    stage_reply(&reply, TOF2CAN_STORAGE_SIZE);
+    end_reply();
+}
+
+/* ================================================================== */
+/*                              Profile                               */
+/* ================================================================== */
+
+_Static_assert(
+    TIMING_PROFILE_READ      == TOF2CAN_PROFILE_STEP_READ      &&
+    TIMING_PROFILE_PROCESS   == TOF2CAN_PROFILE_STEP_PROCESS   &&
+    TIMING_PROFILE_THRESHOLD == TOF2CAN_PROFILE_STEP_THRESHOLD &&
+    TIMING_PROFILE_WRITE     == TOF2CAN_PROFILE_STEP_WRITE     &&
+    TIMING_PROFILE_COUNT     == TOF2CAN_PROFILE_STEP_COUNT     &&
+    TIMING_HISTOGRAM_BUCKETS == TOF2CAN_PROFILE_BUCKET_COUNT,
+    "the cycle profile does not match struct tof2can_profile"
+);
+
+static void write_profile(const struct sensor *s) {
+    begin_reply(TOF2CAN_PROFILE_MASK_ID, s->id);
+    for(int step = 0; step < TOF2CAN_PROFILE_STEP_COUNT; step++) {
+        struct timing_profile data;
+        timing_profile_read(step, &data);
+
+        const uint32_t mean = (data.count ? data.total / data.count : 0);
+        uint16_t words[TOF2CAN_PROFILE_PAGE_COUNT * 3] = {
+            data.count & 0xffff, data.count >> 16,
+            data.min   & 0xffff, data.min   >> 16,
+            data.max   & 0xffff, data.max   >> 16,
+            mean       & 0xffff, mean       >> 16,
+            up_perf_getfreq() / 1000000
+        };
+        for(int b = 0; b < TOF2CAN_PROFILE_BUCKET_COUNT; b++) {
+            const uint32_t count = data.histogram[b];
+            words[9 + b] = (count > 0xffff ? 0xffff : count);
+        }
+
+        for(int page = 0; page < TOF2CAN_PROFILE_PAGE_COUNT; page++) {
+            struct tof2can_profile msg_data = {
+                .step = step,
+                .page = page
+            };
+            memcpy(
+                msg_data.words, &words[page * 3], sizeof(msg_data.words)
+            );
+
+            stage_reply(&msg_data, TOF2CAN_PROFILE_SIZE);
+        }
+    }
+    end_reply();
+}
+
+/* ================================================================== */
+/*                              Filters                               */
+/* ================================================================== */
+
+// Provided by the board (see stm32_can.c)
+extern int stm32l4_can_setfilters(const uint16_t *ids,
+                                  const uint16_t *masks, int count);
+extern int stm32l4_can_getfilter(int index, uint16_t *id, uint16_t *mask);
+
+// The acceptance filters of the CAN controller only let through the
+// messages addressed to the ID of a sensor, of a channel or broadcast
+// (ID=0), so that other traffic on the bus never reaches the receiver.
+// Each ID is matched in two blocks of message types, together covering
+// all messages received by sensors, and broadcast messages without a
+// sensor ID (beacon, sync) are matched alone. If the controller does not
+// have enough filters, each ID is matched in a single wider block, which
+// also covers broadcast messages.
+#define FILTER_BLOCK_MASK 0x79f
+#define FILTER_BLOCK_0    0x680 // 0x680, 0x6a0, 0x6c0, 0x6e0
+#define FILTER_BLOCK_1    0x700 // 0x700, 0x720, 0x740, 0x760
+
+#define FILTER_WIDE_MASK  0x61f
+#define FILTER_WIDE_BLOCK 0x600 // 0x600...0x7e0
+
+#define FILTER_MODE_OPEN   0 // all messages are received
+#define FILTER_MODE_NARROW 1
+#define FILTER_MODE_WIDE   2
+
+#define IS_FILTER_BLOCK(type) ( \
+    ((type) & FILTER_BLOCK_MASK) == FILTER_BLOCK_0 || \
+    ((type) & FILTER_BLOCK_MASK) == FILTER_BLOCK_1    \
+)
+
+_Static_assert(
+    IS_FILTER_BLOCK(TOF2CAN_PROFILE_MASK_ID) &&
+    IS_FILTER_BLOCK(TOF2CAN_EXT_CONFIG_MASK_ID) &&
+    IS_FILTER_BLOCK(TOF2CAN_CONFIG_MASK_ID) &&
+    IS_FILTER_BLOCK(TOF2CAN_SAMPLE_MASK_ID) &&
+    IS_FILTER_BLOCK(TOF2CAN_DATA_PACKET_MASK_ID) &&
+    IS_FILTER_BLOCK(TOF2CAN_PACKED_PACKET_MASK_ID) &&
+    IS_FILTER_BLOCK(TOF2CAN_STORAGE_MASK_ID),
+    "the acceptance filters do not cover all received messages"
+);
+
+static const uint16_t broadcast_ids[] = {
+    TOF2CAN_BEACON_ID, TOF2CAN_SYNC_ID
+};
+#define BROADCAST_ID_COUNT (sizeof(broadcast_ids) / sizeof(uint16_t))
+
+_Static_assert(
+    (TOF2CAN_BEACON_ID & FILTER_WIDE_MASK) == FILTER_WIDE_BLOCK &&
+    (TOF2CAN_SYNC_ID & FILTER_WIDE_MASK) == FILTER_WIDE_BLOCK,
+    "the wide acceptance filters do not cover broadcast messages"
+);
+
+// broadcast, then the sensors and their channels
+#define FILTER_MAX_IDS (1 + TOF_MAX_SENSORS * PROCESSING_CHANNEL_COUNT)
+
+static int filter_mode;
+
+static int set_filters(const uint16_t *ids, int count, int mode) {
+    uint16_t filter_ids[2 * FILTER_MAX_IDS + BROADCAST_ID_COUNT];
+    uint16_t masks[2 * FILTER_MAX_IDS + BROADCAST_ID_COUNT];
+    int n = 0;
+
+    for(int i = 0; mode == FILTER_MODE_NARROW && i < BROADCAST_ID_COUNT;
+        i++) {
+        filter_ids[n] = broadcast_ids[i];
+        masks[n++]    = 0x7ff;
+    }
+
+    for(int i = 0; i < count; i++) {
+        if(mode == FILTER_MODE_NARROW) {
+            filter_ids[n] = FILTER_BLOCK_0 | ids[i];
+            masks[n++]    = FILTER_BLOCK_MASK;
+            filter_ids[n] = FILTER_BLOCK_1 | ids[i];
+            masks[n++]    = FILTER_BLOCK_MASK;
+        } else {
+            filter_ids[n] = FILTER_WIDE_BLOCK | ids[i];
+            masks[n++]    = FILTER_WIDE_MASK;
+        }
+    }
+    return stm32l4_can_setfilters(filter_ids, masks, n);
+}
+
+// Must be called whenever the ID of a sensor or channel changes
+static void update_filters(void) {
+    uint16_t ids[FILTER_MAX_IDS];
+    int count = 0;
+
+    ids[count++] = 0;
+    for(int i = 0; i < tof_sensor_count; i++) {
+        const struct sensor *s = &sensors[i];
+
+        if(s->id != 0)
+            ids[count++] = s->id;
+        for(int c = 1; c < PROCESSING_CHANNEL_COUNT; c++)
+            if(s->channels[c].id != 0)
+                ids[count++] = s->channels[c].id;
+    }
+
+    // use the narrowest filters that fit in the controller
+    if(!set_filters(ids, count, FILTER_MODE_NARROW))
+        filter_mode = FILTER_MODE_NARROW;
+    else if(!set_filters(ids, count, FILTER_MODE_WIDE))
+        filter_mode = FILTER_MODE_WIDE;
+    else if(!stm32l4_can_setfilters(NULL, NULL, 0))
+        filter_mode = FILTER_MODE_OPEN;
+
+    printf(
+        "[CAN-IO] setting acceptance filters for %d IDs (mode=%d)\n",
+        count, filter_mode
+    );
+}
+
+/* ================================================================== */
+/*                           Transmit slots                           */
+/* ================================================================== */
+
+// The user device may divide the time in cycles of slots, which begin
+// when a beacon is received (see struct tof2can_beacon). Batches are
+// then started only in the slot of the sensor that queued them. Times
+// are measured with the cycle counter, since slots may be shorter than
+// the system tick.
+
+// without beacons for this long, data is sent as soon as it is ready
+#define BEACON_TIMEOUT_MS 1000
+
+// the longest message, 8 data bytes with worst-case bit stuffing
+#define FRAME_MAX_BITS 135
+
+// used if the bit timing cannot be read (see CONFIG_STM32L4_CAN1_BAUD)
+#define DEFAULT_BAUD 250000
+
+static struct {
+    bool     enabled;
+    int      count;
+    uint32_t start;  // cycle counter when the last beacon was received
+    uint32_t length; // in cycles
+
+    // the cycle counter wraps around in less than a minute
+    uint32_t start_ms;
+    uint32_t timeout_ms;
+
+    int cycle_ms; // length of a whole cycle, rounded up
+} slots;
+
+static pthread_mutex_t slots_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// time taken to send the longest message, in cycles
+static uint32_t frame_cycles;
+
+static void handle_beacon(const struct can_msg_s *msg, uint32_t received) {
+    // check if message size is correct
+    if(msg->cm_hdr.ch_dlc != TOF2CAN_BEACON_SIZE) {
+        printf(
+            "[CAN-IO] malformed beacon (size=%d, expected=%d)\n",
+            msg->cm_hdr.ch_dlc, TOF2CAN_BEACON_SIZE
+        );
+        return;
+    }
+
+    struct tof2can_beacon beacon;
+    memcpy(&beacon, msg->cm_data, sizeof(beacon));
+
+    const uint32_t cycles_per_us = up_perf_getfreq() / 1000000;
+    const uint32_t cycle_us = (uint32_t) beacon.slot_us * beacon.slot_count;
+    const uint32_t cycle_ms = (cycle_us + 999) / 1000;
+
+    pthread_mutex_lock(&slots_lock);
+    slots.enabled  = (cycle_us > 0);
+    slots.count    = beacon.slot_count;
+    slots.start    = received;
+    slots.length   = beacon.slot_us * cycles_per_us;
+    slots.start_ms = get_ms();
+    slots.cycle_ms = cycle_ms;
+    slots.timeout_ms = (
+        cycle_ms * 2 > BEACON_TIMEOUT_MS ? cycle_ms * 2 : BEACON_TIMEOUT_MS
+    );
+    pthread_mutex_unlock(&slots_lock);
+
+    can_io_tx_stats.beacons++;
+
+    // queued batches may now be sent at a different time
+    can_io_notify();
+}
+
+// Returns how many cycles the sensor with the given ID must wait before
+// starting a batch of 'count' messages (0 = it can start now).
+static uint32_t get_slot_wait(int id, int count, uint32_t now) {
+    uint32_t wait = 0;
+    pthread_mutex_lock(&slots_lock);
+
+    if(slots.enabled && get_ms() - slots.start_ms >= slots.timeout_ms)
+        slots.enabled = false;
+
+    if(slots.enabled) {
+        const uint32_t cycle    = slots.length * slots.count;
+        const uint32_t position = (now - slots.start) % cycle;
 
-static int data_requests = 0;
+        const uint32_t slot_start = (id % slots.count) * slots.length;
+        const uint32_t slot_end   = slot_start + slots.length;
+
+        // batches longer than a slot may be started anywhere in it
+        uint32_t duration = count * frame_cycles;
+        if(duration > slots.length)
+            duration = 0;
+
+        const bool in_slot = (
+            position >= slot_start && position < slot_end &&
+            position + duration <= slot_end
+        );
+        if(!in_slot)
+            wait = (slot_start + cycle - position) % cycle;
+    }
+
+    pthread_mutex_unlock(&slots_lock);
+    return wait;
+}
 
 /* ================================================================== */
 /*                              Receiver                              */
@@ -42,96 +484,949 @@ static int data_requests = 0;
 
 #define RECEIVER_BUFFER_SIZE (sizeof(struct can_msg_s))
 
-static void handle_message(const struct can_msg_s *msg) {
+static void configure_channel(const struct sensor *s,
+                              const struct tof2can_ext_config *config) {
+    const int channel = config->channel.channel;
+
+    // channel 0 is configured by struct tof2can_config
+    if(channel == 0) {
+        printf("[CAN-IO] channel 0 is not an extended setting\n");
+        return;
+    }
+
+    // set processing settings
+    processing_set_mode(
+        s->index, channel, config->channel.processing_mode
+    );
+    processing_set_threshold(s->index, channel, config->channel.threshold);
+    processing_set_threshold_delay(
+        s->index, channel, config->channel.threshold_delay
+    );
+    processing_set_threshold_focus(
+        s->index, channel, config->channel.threshold_focus
+    );
+
+    // set transmission settings
+    can_io_set_transmit_condition(
+        s->index, channel, config->channel.transmit_condition
+    );
+    const int id = (config->channel.enabled ? config->channel.id : 0);
+    const bool enabled = (
+        !can_io_set_channel_id(s->index, channel, id) && id != 0
+    );
+
+    processing_set_enabled(s->index, channel, enabled);
+}
+
+static int handle_ext_config(const struct sensor *s,
+                             const struct tof2can_ext_config *config) {
+    switch(config->key) {
+        case TOF2CAN_EXT_DELTA:
+            can_io_set_delta(
+                s->index,
+                config->delta.enabled,
+                config->delta.deadband,
+                config->delta.keyframe_interval
+            );
+            break;
+
+        case TOF2CAN_EXT_AREA:
+            processing_set_area(
+                s->index,
+                config->area.channel,
+                config->area.x0, config->area.y0,
+                config->area.x1, config->area.y1,
+                config->area.result_selector
+            );
+            break;
+
+        case TOF2CAN_EXT_CHANNEL:
+            configure_channel(s, config);
+            break;
+
+        case TOF2CAN_EXT_SELECTOR:
+            processing_set_selector(
+                s->index,
+                config->selector.channel,
+                config->selector.result_selector,
+                config->selector.percentile
+            );
+            break;
+
+        case TOF2CAN_EXT_FILTER:
+            processing_set_filter(
+                s->index,
+                config->filter.accepted_statuses,
+                config->filter.max_sigma,
+                config->filter.min_signal
+            );
+            break;
+
+        case TOF2CAN_EXT_TEMPORAL:
+            processing_set_temporal_filter(
+                s->index,
+                config->temporal.mode,
+                config->temporal.weight,
+                config->temporal.length
+            );
+            break;
+
+        case TOF2CAN_EXT_TARGETS:
+            processing_set_targets(
+                s->index,
+                config->targets.policy,
+                config->targets.secondary_channels
+            );
+            break;
+
+        case TOF2CAN_EXT_TELEMETRY:
+            can_io_set_telemetry(s->index, config->telemetry.interval_ms);
+            break;
+
+        case TOF2CAN_EXT_TIMESTAMPS:
+            can_io_set_timestamps(s->index, config->timestamps.enabled);
+            break;
+
+        default:
+            printf(
+                "[CAN-IO] unknown extended config key %d\n",
+                config->key
+            );
+            return 1;
+    }
+    return 0;
+}
+
+static int get_ext_config_channel(const struct tof2can_ext_config *config) {
+    switch(config->key) {
+        case TOF2CAN_EXT_AREA:     return config->area.channel;
+        case TOF2CAN_EXT_CHANNEL:  return config->channel.channel;
+        case TOF2CAN_EXT_SELECTOR: return config->selector.channel;
+        default:                   return 0;
+    }
+}
+
+static void record_ext_config(struct sensor *s,
+                              const struct tof2can_ext_config *config) {
+    struct stored_config *current_config = &s->current_config;
+    if(!current_config->valid)
+        return;
+
+    // replace the previous setting with the same key and channel
+    int i;
+    for(i = 0; i < current_config->ext_count; i++) {
+        const struct tof2can_ext_config *old = &current_config->ext[i];
+        if(old->key == config->key &&
+           get_ext_config_channel(old) == get_ext_config_channel(config))
+            break;
+    }
+
+    if(i == STORED_EXT_CONFIG_MAX) {
+        printf("[CAN-IO] too many extended settings to store\n");
+        return;
+    }
+
+    if(i == current_config->ext_count)
+        current_config->ext_count++;
+    current_config->ext[i] = *config;
+}
+
+static void forget_ext_config(struct sensor *s, int key, int channel) {
+    struct stored_config *current_config = &s->current_config;
+    for(int i = 0; i < current_config->ext_count; ) {
+        const struct tof2can_ext_config *old = &current_config->ext[i];
+        if(old->key == key && get_ext_config_channel(old) == channel) {
+            current_config->ext_count--;
+            memmove(
+                &current_config->ext[i], &current_config->ext[i + 1],
+                (current_config->ext_count - i) * sizeof(*old)
+            );
+        } else {
+            i++;
+        }
+    }
+}
+
+// Only sensor settings require ranging to stop: other changes are
+// applied between two frames (see transmit_lock).
+static inline bool needs_restart(const struct sensor *s,
+                                 const struct tof2can_config *config) {
+    if(!s->current_config.valid)
+        return true;
+
+    const struct tof2can_config *old = &s->current_config.config;
+    return config->resolution != old->resolution ||
+           config->frequency  != old->frequency  ||
+           config->sharpener  != old->sharpener;
+}
+
+static void apply_config(struct sensor *s,
+                         const struct tof2can_config *config) {
+    const int sensor = s->index;
+    const uint32_t start = up_perf_gettime();
+    const bool restart = needs_restart(s, config);
+
+    printf(
+        "\n=== Configuring sensor %d (%s) ===\n",
+        sensor, restart ? "restart" : "in place"
+    );
+    board_userled(BOARD_GREEN_LED, true);
+
+    if(restart) {
+        processing_pause(sensor);
+
+        // drop all data requests
+        pthread_mutex_lock(&data_requests_lock);
+        for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++)
+            s->channels[i].data_requests = 0;
+        pthread_mutex_unlock(&data_requests_lock);
+
+        // set ToF settings
+        tof_set_resolution(sensor, config->resolution);
+        tof_set_frequency(sensor, config->frequency);
+        tof_set_sharpener(sensor, config->sharpener);
+    }
+
+    // a restart applies all settings, otherwise only the changed ones
+    // are, so that the state of processing (threshold delays, temporal
+    // filter) and of delta transmission carries on
+    const struct tof2can_config *old = &s->current_config.config;
+
+    // set processing settings (channel 0)
+    if(restart || config->processing_mode != old->processing_mode) {
+        processing_set_mode(sensor, 0, config->processing_mode);
+
+        // the mode replaces the area and selector of channel 0
+        forget_ext_config(s, TOF2CAN_EXT_AREA, 0);
+        forget_ext_config(s, TOF2CAN_EXT_SELECTOR, 0);
+    }
+    if(restart || config->threshold != old->threshold)
+        processing_set_threshold(sensor, 0, config->threshold);
+    if(restart || config->threshold_delay != old->threshold_delay)
+        processing_set_threshold_delay(sensor, 0, config->threshold_delay);
+    if(restart || config->threshold_focus != old->threshold_focus)
+        processing_set_threshold_focus(sensor, 0, config->threshold_focus);
+
+    // set transmission settings
+    if(restart || config->transmit_timing != old->transmit_timing)
+        can_io_set_transmit_timing(sensor, config->transmit_timing);
+    if(restart || config->transmit_condition != old->transmit_condition)
+        can_io_set_transmit_condition(sensor, 0, config->transmit_condition);
+    if(restart || config->data_encoding != old->data_encoding)
+        can_io_set_data_encoding(sensor, config->data_encoding);
+
+    // reset extended settings
+    if(restart) {
+        can_io_set_delta(sensor, false, 0, 1);
+        processing_set_filter(sensor, TOF2CAN_FILTER_DEFAULT_STATUSES, 0, 0);
+        processing_set_temporal_filter(sensor, TOF2CAN_TEMPORAL_NONE, 0, 0);
+        processing_set_targets(sensor, TOF2CAN_TARGET_NEAREST, 0);
+        can_io_set_telemetry(sensor, 0);
+        can_io_set_timestamps(sensor, false);
+        for(int i = 1; i < PROCESSING_CHANNEL_COUNT; i++) {
+            processing_set_enabled(sensor, i, false);
+            can_io_set_channel_id(sensor, i, 0);
+        }
+    }
+
+    if(restart)
+        processing_resume(sensor);
+    board_userled(BOARD_GREEN_LED, false);
+
+    // update reconfiguration latency
+    const uint32_t us = (
+        (uint32_t) (up_perf_gettime() - start) /
+        (up_perf_getfreq() / 1000000)
+    );
+    struct can_io_reconfig_latency *latency =
+        &can_io_reconfig_stats.latency[
+            restart ? CAN_IO_RECONFIG_RESTART : CAN_IO_RECONFIG_IN_PLACE
+        ];
+    latency->count++;
+    latency->last_us = us;
+    if(us > latency->max_us)
+        latency->max_us = us;
+
+    printf("[CAN-IO] configured in %lu us\n", (unsigned long) us);
+    printf("\n"); // write blank line as separator
+
+    // extended settings received from now on are recorded after this,
+    // and the ones kept in place stay recorded
+    if(restart) {
+        s->current_config = (struct stored_config) {
+            .config = *config,
+            .valid  = true
+        };
+    } else {
+        s->current_config.config = *config;
+    }
+}
+
+static inline int get_channel_id(const struct sensor *s, int channel) {
+    return (channel == 0 ? s->id : s->channels[channel].id);
+}
+
+// Returns true if the ID is used by a sensor or any of its channels
+static bool is_id_used(int id) {
+    for(int i = 0; i < tof_sensor_count; i++) {
+        if(sensors[i].id == id)
+            return true;
+        for(int c = 1; c < PROCESSING_CHANNEL_COUNT; c++)
+            if(sensors[i].channels[c].id == id)
+                return true;
+    }
+    return false;
+}
+
+static bool request_data(int id) {
+    bool requested = false;
+    pthread_mutex_lock(&data_requests_lock);
+
+    // request data from the addressed channels (ID=0 is broadcast)
+    for(int i = 0; i < tof_sensor_count; i++) {
+        struct sensor *s = &sensors[i];
+
+        for(int c = 0; c < PROCESSING_CHANNEL_COUNT; c++) {
+            const int channel_id = get_channel_id(s, c);
+
+            // skip disabled channels
+            if(c != 0 && channel_id == 0)
+                continue;
+
+            if(id == 0 || id == channel_id) {
+                s->channels[c].data_requests++;
+                requested = true;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&data_requests_lock);
+    return requested;
+}
+
+static void handle_sensor_message(struct sensor *s,
+                                  const struct can_msg_s *msg,
+                                  int msg_type) {
+    switch(msg_type) {
+        case TOF2CAN_CONFIG_MASK_ID: {
+            // check if message size is correct
+            if(msg->cm_hdr.ch_dlc != TOF2CAN_CONFIG_SIZE) {
+                printf(
+                    "[CAN-IO] malformed config message "
+                    "(size=%d, expected=%d)\n",
+                    msg->cm_hdr.ch_dlc, TOF2CAN_CONFIG_SIZE
+                );
+                break;
+            }
+
+            struct tof2can_config config;
+            memcpy(&config, msg->cm_data, sizeof(config));
+            apply_config(s, &config);
+        } break;
+
+        case TOF2CAN_EXT_CONFIG_MASK_ID: {
+            // check if message size is correct
+            if(msg->cm_hdr.ch_dlc != TOF2CAN_EXT_CONFIG_SIZE) {
+                printf(
+                    "[CAN-IO] malformed extended config message "
+                    "(size=%d, expected=%d)\n",
+                    msg->cm_hdr.ch_dlc, TOF2CAN_EXT_CONFIG_SIZE
+                );
+                break;
+            }
+
+            struct tof2can_ext_config config;
+            memcpy(&config, msg->cm_data, sizeof(config));
+            if(!handle_ext_config(s, &config))
+                record_ext_config(s, &config);
+        } break;
+
+        case TOF2CAN_STORAGE_MASK_ID: {
+            // ignore stored messages read back from other sensors
+            if(msg->cm_hdr.ch_dlc != TOF2CAN_STORAGE_SIZE)
+                break;
+
+            struct tof2can_storage request;
+            memcpy(&request, msg->cm_data, sizeof(request));
+
+            // ignore replies sent by other sensors
+            if(request.is_reply)
+                break;
+
+            handle_storage(s, request.command);
+        } break;
+
+        case TOF2CAN_PROFILE_MASK_ID:
+            // ignore profiles sent by other sensors
+            if(msg->cm_hdr.ch_rtr)
+                write_profile(s);
+            break;
+    }
+}
+
+static void handle_sync(const struct can_msg_s *msg, uint32_t received) {
+    // check if message size is correct
+    if(msg->cm_hdr.ch_dlc != TOF2CAN_SYNC_SIZE) {
+        printf(
+            "[CAN-IO] malformed sync message (size=%d, expected=%d)\n",
+            msg->cm_hdr.ch_dlc, TOF2CAN_SYNC_SIZE
+        );
+        return;
+    }
+
+    struct tof2can_sync sync;
+    memcpy(&sync, msg->cm_data, sizeof(sync));
+    sync_handle(sync.time_us, received);
+}
+
+// 'received' is the cycle counter when the message was read
+static void handle_message(const struct can_msg_s *msg, uint32_t received) {
     const int msg_sensor_id = msg->cm_hdr.ch_id % TOF2CAN_MAX_SENSOR_COUNT;
     const int msg_type      = msg->cm_hdr.ch_id - msg_sensor_id;
 
-    // check if message is addressed to this device (ID=0 is broadcast)
-    if(msg_sensor_id != 0 && msg_sensor_id != sensor_id)
+    can_io_rx_stats.received++;
+
+    if(msg->cm_hdr.ch_id == TOF2CAN_BEACON_ID) {
+        handle_beacon(msg, received);
+        return;
+    }
+    if(msg->cm_hdr.ch_id == TOF2CAN_SYNC_ID) {
+        handle_sync(msg, received);
+        return;
+    }
+
+    // data requests may be addressed to the ID of any channel
+    const bool is_data_type = (
+        msg_type == TOF2CAN_SAMPLE_MASK_ID ||
+        msg_type == TOF2CAN_DATA_PACKET_MASK_ID ||
+        msg_type == TOF2CAN_PACKED_PACKET_MASK_ID
+    );
+    if(is_data_type) {
+        // if RTR bit is set, request a data message
+        if(msg->cm_hdr.ch_rtr && request_data(msg_sensor_id))
+            can_io_notify();
+        else
+            can_io_rx_stats.ignored++;
         return;
+    }
+
+    // handle the message for each addressed sensor (ID=0 is broadcast)
+    bool addressed = false;
+    for(int i = 0; i < tof_sensor_count; i++) {
+        if(msg_sensor_id == 0 || msg_sensor_id == sensors[i].id) {
+            handle_sensor_message(&sensors[i], msg, msg_type);
+            addressed = true;
+        }
+    }
+
+    if(!addressed)
+        can_io_rx_stats.ignored++;
+}
+
+// Provided by the board (see stm32_can.c)
+extern bool stm32l4_can_rxoverrun(void);
+
+static void receiver_run(void) {
+    static char buffer[RECEIVER_BUFFER_SIZE];
+    int offset = 0;
+
+    // the CAN driver does not report messages lost by the controller
+    if(stm32l4_can_rxoverrun())
+        can_io_rx_stats.overruns++;
+
+    // read CAN message(s)
+    int nbytes = read(can_fd, buffer, RECEIVER_BUFFER_SIZE);
+    if(nbytes < 0)
+        return;
+    const uint32_t received = up_perf_gettime();
+
+    // handle CAN message(s)
+    while(offset < nbytes) {
+        struct can_msg_s *msg = (struct can_msg_s *) &buffer[offset];
+        handle_message(msg, received);
+
+        // move buffer offset forward
+        int msglen = CAN_MSGLEN(msg->cm_hdr.ch_dlc);
+        offset += msglen;
+    }
+}
+
+/* ================================================================== */
+/*                          Transmit queue                            */
+/* ================================================================== */
+
+// Batches of CAN messages are written to the device whole: a batch is
+// queued until the TX FIFO has room for it, and queued batches are
+// dropped whole rather than sent in part. A batch is dropped when:
+// - a newer batch with the same ID is queued (unless the newer batch
+//   only holds the changes since the older one)
+// - it was not started within TX_DEADLINE_MS (plus a cycle of slots,
+//   if transmit slots are used)
+// - the queue is full, oldest first
+// Only the batch being written is never dropped. With transmit slots,
+// a batch waiting for its slot lets the batches of other sensors go
+// first.
+#define TX_DEADLINE_MS 100
+
+// wait at most this long before trying to write queued messages again
+#define TX_RETRY_MS 2
+
+// the largest batch: a timestamp, then 3 samples per data packet
+#define TX_BATCH_MAX_FRAMES (1 + (PROCESSING_DATA_MAX_LENGTH + 2) / 3)
+
+// the largest reply to a request: the cycle profile
+#define TX_REPLY_FRAMES \
+    (TOF2CAN_PROFILE_STEP_COUNT * TOF2CAN_PROFILE_PAGE_COUNT)
+#define TX_REPLY_BATCHES \
+    ((TX_REPLY_FRAMES + TX_BATCH_MAX_FRAMES - 1) / TX_BATCH_MAX_FRAMES)
+
+_Static_assert(
+    1 + STORED_EXT_CONFIG_MAX + 1 <= TX_REPLY_FRAMES,
+    "the reply to a storage read does not fit in the transmit queue"
+);
+
+// The queue holds the largest batch of every channel of every sensor,
+// plus a telemetry report per sensor, so that a frame of each sensor
+// fits while the bus is busy, plus a reply to a request
+#define TX_QUEUE_BATCHES (TOF_MAX_SENSORS * (PROCESSING_CHANNEL_COUNT + 1) + \
+    TX_REPLY_BATCHES)
+#define TX_QUEUE_FRAMES  (TOF_MAX_SENSORS * ( \
+    PROCESSING_CHANNEL_COUNT * TX_BATCH_MAX_FRAMES + \
+    TOF2CAN_TELEMETRY_PAGE_COUNT                     \
+) + TX_REPLY_FRAMES)
+
+struct tx_batch {
+    int  id;
+    int  sensor_id; // sets the transmit slot
+    int  remaining; // messages not yet written
+    bool started;
+    bool delta;     // depends on the previous batch with the same ID
+    bool *sync;     // cleared if the batch is dropped (may be NULL)
+    uint32_t queued_ms;
+};
+
+// Messages of all the queued batches, in order. Written messages are
+// removed from the front.
+static struct {
+    struct can_msg_s frames[TX_QUEUE_FRAMES];
+    int frame_count;
+
+    struct tx_batch batches[TX_QUEUE_BATCHES];
+    int batch_count;
+
+    // time until queued messages may be written (if any are queued)
+    int retry_ms;
+} tx_queue;
+
+// messages of the batch being built
+static struct {
+    struct can_msg_s frames[TX_BATCH_MAX_FRAMES];
+    int count;
+    int sensor_id;
+
+    // capture time of the data being sent (see struct tof2can_timestamp)
+    bool     timestamps; // false if not sent
+    uint16_t timestamp;
+    bool     synced;
+} tx_staged;
+
+static int get_first_frame(int batch) {
+    int first = 0;
+    for(int i = 0; i < batch; i++)
+        first += tx_queue.batches[i].remaining;
+    return first;
+}
+
+static void remove_batch(int batch) {
+    const int first = get_first_frame(batch);
+    const int count = tx_queue.batches[batch].remaining;
+
+    memmove(
+        &tx_queue.frames[first], &tx_queue.frames[first + count],
+        (tx_queue.frame_count - first - count) * sizeof(struct can_msg_s)
+    );
+    tx_queue.frame_count -= count;
+
+    memmove(
+        &tx_queue.batches[batch], &tx_queue.batches[batch + 1],
+        (tx_queue.batch_count - batch - 1) * sizeof(struct tx_batch)
+    );
+    tx_queue.batch_count--;
+}
+
+// Drops a batch that was not started, along with the later batches
+// depending on it
+static void drop_batch(int batch, bool invalidate) {
+    const int id = tx_queue.batches[batch].id;
+
+    can_io_tx_stats.dropped_batches++;
+    can_io_tx_stats.dropped_frames += tx_queue.batches[batch].remaining;
+    if(invalidate && tx_queue.batches[batch].sync)
+        *tx_queue.batches[batch].sync = false;
+    remove_batch(batch);
+
+    if(!invalidate)
+        return;
+
+    for(int i = batch; i < tx_queue.batch_count; ) {
+        const struct tx_batch *b = &tx_queue.batches[i];
+        if(b->id == id && b->delta && !b->started)
+            drop_batch(i, true);
+        else
+            i++;
+    }
+}
+
+// batches may wait up to a cycle for their slot
+static inline uint32_t get_deadline_ms(void) {
+    return TX_DEADLINE_MS + (slots.enabled ? slots.cycle_ms : 0);
+}
+
+static void drop_stale_batches(void) {
+    const uint32_t now = get_ms();
+    const uint32_t deadline_ms = get_deadline_ms();
+
+    for(int i = 0; i < tx_queue.batch_count; ) {
+        const struct tx_batch *b = &tx_queue.batches[i];
+        if(!b->started && now - b->queued_ms > deadline_ms)
+            drop_batch(i, true);
+        else
+            i++;
+    }
+}
+
+// Returns the oldest batch that can be dropped, or -1
+static int get_oldest_droppable(void) {
+    for(int i = 0; i < tx_queue.batch_count; i++)
+        if(!tx_queue.batches[i].started)
+            return i;
+    return -1;
+}
+
+// Writes the messages of a batch until the TX FIFO is full. Returns 1
+// if the batch is not written entirely yet.
+static int write_batch(int index, uint32_t now) {
+    struct tx_batch *batch = &tx_queue.batches[index];
+    const int first = get_first_frame(index);
+    const uint32_t deadline_ms = get_deadline_ms();
+
+    int written = 0;
+    bool error  = false;
+
+    while(written < batch->remaining) {
+        const struct can_msg_s *msg = &tx_queue.frames[first + written];
+
+        const int msglen = CAN_MSGLEN(msg->cm_hdr.ch_dlc);
+        const int nbytes = write(can_fd, msg, msglen);
+        if(nbytes != msglen) {
+            // the TX FIFO is full: retry later
+            if(nbytes < 0 && errno == EAGAIN)
+                break;
+
+            LOG(
+                LOG_EVENT_CAN_WRITE_ERROR,
+                msg->cm_hdr.ch_id, (nbytes < 0 ? errno : 0)
+            );
+            can_io_tx_stats.write_errors++;
+            error = true;
+            break;
+        }
+        written++;
+
+        can_io_tx_stats.frames++;
+        if(now - batch->queued_ms > deadline_ms)
+            can_io_tx_stats.late_frames++;
+        batch->started = true;
+    }
+
+    memmove(
+        &tx_queue.frames[first], &tx_queue.frames[first + written],
+        (tx_queue.frame_count - first - written) * sizeof(struct can_msg_s)
+    );
+    tx_queue.frame_count -= written;
+    batch->remaining     -= written;
+
+    // give up on the rest of the batch
+    if(error) {
+        can_io_tx_stats.dropped_batches++;
+        can_io_tx_stats.dropped_frames += batch->remaining;
+        if(batch->sync)
+            *batch->sync = false;
+        remove_batch(index);
+        return 0;
+    }
+
+    if(batch->remaining > 0)
+        return 1;
+
+    can_io_tx_stats.batches++;
+    remove_batch(index);
+    return 0;
+}
+
+// Writes queued messages until the TX FIFO is full, skipping batches
+// that are waiting for their slot
+static void tx_flush(void) {
+    drop_stale_batches();
+
+    const uint32_t now    = get_ms();
+    const uint32_t cycles = up_perf_gettime();
+
+    uint32_t slot_wait = 0; // shortest wait for a slot, in cycles
+    tx_queue.retry_ms = TX_RETRY_MS;
+
+    for(int i = 0; i < tx_queue.batch_count; ) {
+        const struct tx_batch *batch = &tx_queue.batches[i];
+
+        if(!batch->started) {
+            const uint32_t wait = get_slot_wait(
+                batch->sensor_id, batch->remaining, cycles
+            );
+            if(wait != 0) {
+                if(slot_wait == 0 || wait < slot_wait)
+                    slot_wait = wait;
+                i++;
+                continue;
+            }
+        }
+
+        // batches are written one at a time
+        if(write_batch(i, now))
+            return;
+    }
+
+    // the batches left are waiting for their slot
+    if(slot_wait != 0) {
+        const uint32_t cycles_per_ms = up_perf_getfreq() / 1000;
+        tx_queue.retry_ms = (slot_wait + cycles_per_ms - 1) / cycles_per_ms;
+    }
+}
+
+static struct can_msg_s *stage_frame(void) {
+    return &tx_staged.frames[tx_staged.count++];
+}
+
+static int reject_batch(int count, bool *sync) {
+    can_io_tx_stats.dropped_batches++;
+    can_io_tx_stats.dropped_frames += count;
+    if(sync)
+        *sync = false;
+
+    tx_flush();
+    return 1;
+}
+
+// Queues the staged messages as a batch, then writes as many queued
+// messages as possible. Returns 1 if the batch was dropped.
+static int submit_batch(int id, bool delta, bool *sync) {
+    const int count = tx_staged.count;
+    tx_staged.count = 0;
+
+    // older batches with the same ID are stale
+    for(int i = 0; !delta && i < tx_queue.batch_count; ) {
+        const struct tx_batch *b = &tx_queue.batches[i];
+        if(b->id == id && !b->started)
+            drop_batch(i, false);
+        else
+            i++;
+    }
+
+    // make room, oldest batches first
+    while(tx_queue.frame_count + count > TX_QUEUE_FRAMES ||
+          tx_queue.batch_count == TX_QUEUE_BATCHES) {
+        const int oldest = get_oldest_droppable();
+        if(oldest < 0)
+            return reject_batch(count, sync);
+        drop_batch(oldest, true);
+    }
+
+    // a batch of changes is useless if the batches before it were dropped
+    if(delta && sync && !*sync)
+        return reject_batch(count, sync);
+
+    memcpy(
+        &tx_queue.frames[tx_queue.frame_count], tx_staged.frames,
+        count * sizeof(struct can_msg_s)
+    );
+    tx_queue.frame_count += count;
+
+    tx_queue.batches[tx_queue.batch_count++] = (struct tx_batch) {
+        .id        = id,
+        .sensor_id = tx_staged.sensor_id,
+        .remaining = count,
+        .delta     = delta,
+        .sync      = sync,
+        .queued_ms = get_ms()
+    };
+
+    if(tx_queue.frame_count > can_io_tx_stats.max_queued_frames)
+        can_io_tx_stats.max_queued_frames = tx_queue.frame_count;
+
+    tx_flush();
+    return 0;
+}
+
+// full CAN ID of the reply being staged
+static int reply_id;
+
+static void begin_reply(int msg_type, int id) {
+    pthread_mutex_lock(&transmit_lock);
+    reply_id = msg_type | id;
+    tx_staged.sensor_id = id;
+}
+
+static void stage_reply(const void *data, int datalen) {
+    // long replies are queued as consecutive batches, each one depending
+    // on the previous one, so that a reply is never cut in the middle
+    if(tx_staged.count == TX_BATCH_MAX_FRAMES)
+        submit_batch(reply_id, true, NULL);
+
+    struct can_msg_s *msg = stage_frame();
+
+    // set CAN header
+    msg->cm_hdr = (struct can_hdr_s) {
+        .ch_id  = reply_id,
+        .ch_dlc = datalen,
+        .ch_rtr = false,
+        .ch_tcf = false
+    };
+
+    // set CAN data
+    memcpy(msg->cm_data, data, datalen);
+}
+
+static void end_reply(void) {
+    if(tx_staged.count > 0)
+        submit_batch(reply_id, true, NULL);
+    pthread_mutex_unlock(&transmit_lock);
 
-    switch(msg_type) {
-        case TOF2CAN_CONFIG_MASK_ID: {
-            // check if message size is correct
-            if(msg->cm_hdr.ch_dlc != TOF2CAN_CONFIG_SIZE) {
-                printf(
-                    "[CAN-IO] malformed config message "
-                    "(size=%d, expected=%d)\n",
-                    msg->cm_hdr.ch_dlc, TOF2CAN_CONFIG_SIZE
-                );
-                break;
-            }
+    // the sender writes what did not fit in the TX FIFO
+    can_io_notify();
+}
 
-            printf("\n=== Configuring ===\n");
-            board_userled(BOARD_GREEN_LED, true);
-            processing_pause();
-            data_requests = 0; // drop all data requests
+/* ================================================================== */
+/*                             Telemetry                              */
+/* ================================================================== */
 
-            struct tof2can_config *config =
-                (struct tof2can_config *) &msg->cm_data;
+static void write_telemetry(struct sensor *s, uint32_t now) {
+    const uint32_t elapsed_ms = now - s->telemetry.last_ms;
+    const uint32_t loops = main_loop_count - s->telemetry.last_loop_count;
+    s->telemetry.last_ms         = now;
+    s->telemetry.last_loop_count += loops;
 
-            // set ToF settings
-            tof_set_resolution(config->resolution);
-            tof_set_frequency(config->frequency);
-            tof_set_sharpener(config->sharpener);
+    // counters are truncated to 16 bits: the receiver unwraps them
+    const uint16_t values[TOF2CAN_TELEMETRY_VALUE_COUNT] = {
+        [TOF2CAN_TELEMETRY_FRAMES_ACQUIRED] =
+            processing_frames_acquired[s->index],
+        [TOF2CAN_TELEMETRY_FRAMES_SENT]       = s->telemetry.frames_sent,
+        [TOF2CAN_TELEMETRY_FRAMES_SUPPRESSED] =
+            s->telemetry.frames_suppressed,
+        [TOF2CAN_TELEMETRY_CAN_WRITE_ERRORS]  = can_io_tx_stats.write_errors,
+        [TOF2CAN_TELEMETRY_I2C_ERRORS]        = tof_get_i2c_errors(),
+        [TOF2CAN_TELEMETRY_RX_OVERRUNS]       = can_io_rx_stats.overruns,
+        [TOF2CAN_TELEMETRY_LOOP_RATE]         = (
+            elapsed_ms == 0 ? 0 : (uint64_t) loops * 1000 / elapsed_ms
+        ),
+        [TOF2CAN_TELEMETRY_TX_DROPPED]  = can_io_tx_stats.dropped_batches,
+        [TOF2CAN_TELEMETRY_UPTIME]      = now / 1000
+    };
 
-            // set processing settings
-            processing_set_mode(config->processing_mode);
-            processing_set_threshold(config->threshold);
-            processing_set_threshold_delay(config->threshold_delay);
-            processing_set_threshold_focus(config->threshold_focus);
+    tx_staged.sensor_id = s->id;
+    for(int page = 0; page < TOF2CAN_TELEMETRY_PAGE_COUNT; page++) {
+        struct can_msg_s *msg = stage_frame();
 
-            // set transmission settings
-            can_io_set_transmit_timing(config->transmit_timing);
-            can_io_set_transmit_condition(config->transmit_condition);
+        const int datalen = sizeof(struct tof2can_telemetry);
 
-            processing_resume();
-            board_userled(BOARD_GREEN_LED, false);
-            printf("\n"); // write blank line as separator
-        } break;
+        // set CAN header
+        msg->cm_hdr = (struct can_hdr_s) {
+            .ch_id  = TOF2CAN_TELEMETRY_MASK_ID | s->id,
+            .ch_dlc = datalen,
+            .ch_rtr = false,
+            .ch_tcf = false
+        };
 
-        case TOF2CAN_SAMPLE_MASK_ID:
-        case TOF2CAN_DATA_PACKET_MASK_ID: {
-            // if RTR bit is set, request a data message
-            if(msg->cm_hdr.ch_rtr)
-                data_requests++;
-        } break;
+        // set CAN data
+        struct tof2can_telemetry msg_data = {
+            .page     = page,
+            .sequence = s->telemetry.sequence
+        };
+        memcpy(msg_data.values, &values[page * 3], sizeof(msg_data.values));
+        memcpy(msg->cm_data, &msg_data, datalen);
     }
+    s->telemetry.sequence++;
+
+    // batches of data are identified by the sensor or channel ID alone,
+    // so the full CAN ID keeps reports from replacing them
+    submit_batch(TOF2CAN_TELEMETRY_MASK_ID | s->id, false, NULL);
 }
 
-static void receiver_run(void) {
-    static char buffer[RECEIVER_BUFFER_SIZE];
-    int offset = 0;
+// Sends the reports that are due. Returns the time until the next
+// report, or -1 if no sensor sends reports.
+static int telemetry_run(void) {
+    const uint32_t now = get_ms();
+    int wait_ms = -1;
 
-    // read CAN message(s)
-    int nbytes = read(can_fd, buffer, RECEIVER_BUFFER_SIZE);
-    if(nbytes < 0)
-        return;
+    pthread_mutex_lock(&transmit_lock);
+    for(int i = 0; i < tof_sensor_count; i++) {
+        struct sensor *s = &sensors[i];
+        const int interval_ms = s->telemetry.interval_ms;
+        if(interval_ms == 0)
+            continue;
 
-    // handle CAN message(s)
-    while(offset < nbytes) {
-        struct can_msg_s *msg = (struct can_msg_s *) &buffer[offset];
-        handle_message(msg);
+        if((int32_t) (now - s->telemetry.next_ms) >= 0) {
+            write_telemetry(s, now);
+            s->telemetry.next_ms = now + interval_ms;
+        }
 
-        // move buffer offset forward
-        int msglen = CAN_MSGLEN(msg->cm_hdr.ch_dlc);
-        offset += msglen;
+        const int remaining = s->telemetry.next_ms - now;
+        if(wait_ms < 0 || remaining < wait_ms)
+            wait_ms = remaining;
     }
+    pthread_mutex_unlock(&transmit_lock);
+    return wait_ms;
 }
 
 /* ================================================================== */
 /*                               Sender                               */
 /* ================================================================== */
 
-static int write_single_sample(int16_t distance, bool below_threshold) {
-    struct can_msg_s msg;
+// Stages the capture time of a sample or batch, to be sent before it
+static void stage_timestamp(int id, int batch_id) {
+    if(!tx_staged.timestamps)
+        return;
+
+    struct can_msg_s *msg = stage_frame();
+
+    const int datalen = sizeof(struct tof2can_timestamp);
+
+    // set CAN header
+    msg->cm_hdr = (struct can_hdr_s) {
+        .ch_id  = TOF2CAN_TIMESTAMP_MASK_ID | id,
+        .ch_dlc = datalen,
+        .ch_rtr = false,
+        .ch_tcf = false
+    };
+
+    // set CAN data
+    struct tof2can_timestamp msg_data = {
+        .batch_id  = batch_id,
+        .synced    = tx_staged.synced,
+        .timestamp = tx_staged.timestamp
+    };
+    memcpy(msg->cm_data, &msg_data, datalen);
+}
+
+static int write_single_sample(int id, int16_t distance,
+                               bool below_threshold) {
+    stage_timestamp(id, TOF2CAN_TIMESTAMP_SAMPLE);
+
+    struct can_msg_s *msg = stage_frame();
 
     const int datalen = sizeof(struct tof2can_sample);
-    const int id = TOF2CAN_SAMPLE_MASK_ID | sensor_id;
 
     // set CAN header
-    msg.cm_hdr = (struct can_hdr_s) {
-        .ch_id  = id,
+    msg->cm_hdr = (struct can_hdr_s) {
+        .ch_id  = TOF2CAN_SAMPLE_MASK_ID | id,
         .ch_dlc = datalen,
         .ch_rtr = false,
         .ch_tcf = false
@@ -142,30 +1437,23 @@ static int write_single_sample(int16_t distance, bool below_threshold) {
         .distance        = distance,
         .below_threshold = below_threshold
     };
-    memcpy(msg.cm_data, &msg_data, datalen);
+    memcpy(msg->cm_data, &msg_data, datalen);
 
-    // write CAN message
-    const int msglen = CAN_MSGLEN(datalen);
-    const int nbytes = write(can_fd, &msg, msglen);
-    if(nbytes != msglen) {
-        printf("[CAN-IO] error writing to CAN device\n");
-        return 1;
-    }
-    return 0;
+    return submit_batch(id, false, NULL);
 }
 
-static int write_data_packets(int16_t *data, int length) {
-    static int batch_id = 0;
-    batch_id++;
+static int write_data_packets(struct channel *channel, int id,
+                              const int16_t *data, int length) {
+    const int batch_id = ++channel->batch_id;
 
-    struct can_msg_s msg;
+    // with the batch ID as truncated in the packets
+    stage_timestamp(id, batch_id & 0x1f);
 
     const int datalen = sizeof(struct tof2can_data_packet);
-    const int id = TOF2CAN_DATA_PACKET_MASK_ID | sensor_id;
 
-    // set CAN header
-    msg.cm_hdr = (struct can_hdr_s) {
-        .ch_id  = id,
+    // CAN header of all packets
+    const struct can_hdr_s header = {
+        .ch_id  = TOF2CAN_DATA_PACKET_MASK_ID | id,
         .ch_dlc = datalen,
         .ch_rtr = false,
         .ch_tcf = false
@@ -190,22 +1478,157 @@ static int write_data_packets(int16_t *data, int length) {
             packet.data_length++;
         }
 
-        // set CAN data
-        memcpy(msg.cm_data, &packet, datalen);
+        // set CAN message
+        struct can_msg_s *msg = stage_frame();
+        msg->cm_hdr = header;
+        memcpy(msg->cm_data, &packet, datalen);
+    }
+    return submit_batch(id, false, NULL);
+}
 
-        // write CAN message
-        const int msglen = CAN_MSGLEN(datalen);
-        const int nbytes = write(can_fd, &msg, msglen);
-        if(nbytes != msglen) {
-            printf("[CAN-IO] error writing to CAN device\n");
-            return 1;
+static inline uint16_t pack_sample(int16_t sample) {
+    if(sample < 0)
+        return TOF2CAN_PACKED_INVALID;
+    if(sample >= TOF2CAN_PACKED_INVALID)
+        return TOF2CAN_PACKED_INVALID - 1;
+    return sample;
+}
+
+// If given, 'sync' is cleared when the batch is dropped
+static int write_packed_words(struct channel *channel, int id,
+                              const uint16_t *words, int count,
+                              bool delta, bool *sync) {
+    const int batch_id = ++channel->batch_id;
+
+    // with the batch ID as truncated in the packets
+    stage_timestamp(id, batch_id & 0x1f);
+
+    const int datalen = sizeof(struct tof2can_packed_packet);
+
+    // CAN header of all packets
+    const struct can_hdr_s header = {
+        .ch_id  = TOF2CAN_PACKED_PACKET_MASK_ID | id,
+        .ch_dlc = datalen,
+        .ch_rtr = false,
+        .ch_tcf = false
+    };
+
+    const int packet_count = (count + 3) / 4;
+    for(int i = 0; i < packet_count; i++) {
+        struct tof2can_packed_packet packet = {
+            .sequence_number = i,
+            .batch_id        = batch_id,
+            .last_of_batch   = (i == packet_count - 1),
+            .delta           = delta
+        };
+
+        // set packet sample data, two values (3 bytes) at a time
+        packet.data_length = 0;
+        for(int s = 0; s < 4; s += 2) {
+            const int word_index = i * 4 + s;
+            if(word_index >= count)
+                break;
+
+            const uint16_t w0 = words[word_index];
+            uint16_t w1 = 0;
+            if(word_index + 1 < count) {
+                w1 = words[word_index + 1];
+                packet.data_length += 2;
+            } else {
+                packet.data_length += 1;
+            }
+
+            uint8_t *bytes = &packet.data[s / 2 * 3];
+            bytes[0] = w0 & 0xff;
+            bytes[1] = (w0 >> 8) | (w1 << 4);
+            bytes[2] = w1 >> 4;
         }
+
+        // set CAN message
+        struct can_msg_s *msg = stage_frame();
+        msg->cm_hdr = header;
+        memcpy(msg->cm_data, &packet, datalen);
     }
-    return 0;
+    return submit_batch(id, delta, sync);
+}
+
+static int write_packed_packets(struct channel *channel, int id,
+                                const int16_t *data, int length) {
+    uint16_t words[PROCESSING_DATA_MAX_LENGTH];
+    for(int i = 0; i < length; i++)
+        words[i] = pack_sample(data[i]);
+
+    return write_packed_words(channel, id, words, length, false, NULL);
+}
+
+static inline bool zone_changed(uint16_t current, uint16_t previous,
+                                int deadband) {
+    const bool current_valid  = (current  != TOF2CAN_PACKED_INVALID);
+    const bool previous_valid = (previous != TOF2CAN_PACKED_INVALID);
+
+    // a zone becoming valid or invalid is always a change
+    if(current_valid != previous_valid)
+        return true;
+
+    return abs(current - previous) > deadband;
+}
+
+static int write_delta_packets(const struct sensor *s,
+                               struct channel *channel, int id,
+                               const int16_t *data, int length) {
+    // count of zones, zone bitmap and samples of the changed zones
+    uint16_t words[1 + DELTA_BITMAP_WORDS + PROCESSING_DATA_MAX_LENGTH];
+    uint16_t *reference = channel->reference.values;
+
+    const bool keyframe = (
+        !channel->reference.valid ||
+        channel->reference.length != length ||
+        channel->reference.batches_since_keyframe + 1 >=
+            s->delta.keyframe_interval
+    );
+
+    // keyframes are sent as regular batches of packed packets
+    if(keyframe) {
+        for(int i = 0; i < length; i++)
+            reference[i] = pack_sample(data[i]);
+        channel->reference.length = length;
+        channel->reference.batches_since_keyframe = 0;
+
+        channel->reference.valid = true;
+        return write_packed_words(
+            channel, id, reference, length, false, &channel->reference.valid
+        );
+    }
+
+    const int bitmap_words = (length + 11) / 12;
+    int count = 1 + bitmap_words;
+
+    words[0] = length;
+    memset(&words[1], 0, bitmap_words * sizeof(uint16_t));
+
+    // set bitmap and samples of changed zones
+    for(int i = 0; i < length; i++) {
+        const uint16_t sample = pack_sample(data[i]);
+        if(!zone_changed(sample, reference[i], s->delta.deadband))
+            continue;
+
+        words[1 + i / 12] |= (1 << (i % 12));
+        words[count++] = sample;
+
+        // keep the reference equal to what the receiver reconstructs
+        reference[i] = sample;
+    }
+    channel->reference.batches_since_keyframe++;
+
+    // if the batch is dropped, the receiver falls out of sync
+    return write_packed_words(
+        channel, id, words, count, true, &channel->reference.valid
+    );
 }
 
-static bool should_transmit(bool below_threshold, bool threshold_event) {
-    switch(transmit_condition) {
+static bool should_transmit(int condition,
+                            bool below_threshold, bool threshold_event) {
+    switch(condition) {
         case TOF2CAN_CONDITION_ALWAYS_TRUE:
             return true;
 
@@ -227,40 +1650,171 @@ static bool should_transmit(bool below_threshold, bool threshold_event) {
     return false;
 }
 
-static int retrieve_data(int16_t *buffer, int *length, bool *below_thd) {
-    bool thd_event;
-    if(processing_get_data(buffer, length, below_thd, &thd_event))
-        return 1;
+static bool transmit_channel(struct sensor *s, int index,
+                             const struct processing_data *data) {
+    struct channel *channel = &s->channels[index];
+    const int id = get_channel_id(s, index);
+
+    if(!data->available)
+        return false;
+
+    // if timing is on-demand, only serve channels with data requests
+    if(s->transmit_timing == TOF2CAN_TIMING_ON_DEMAND &&
+       channel->data_requests == 0)
+        return false;
+
+    // check if data meets the transmit condition of the channel
+    const bool transmit = should_transmit(
+        channel->transmit_condition,
+        data->below_threshold, data->threshold_event
+    );
+    if(!transmit) {
+        s->telemetry.frames_suppressed++;
+        return false;
+    }
+
+    // send CAN message(s)
+    const uint32_t start = timing_profile_begin();
+    if(data->buffer_length == 1)
+        write_single_sample(id, data->buffer[0], data->below_threshold);
+    else if(s->delta.enabled)
+        write_delta_packets(s, channel, id, data->buffer, data->buffer_length);
+    else if(s->data_encoding == TOF2CAN_ENCODING_PACKED_PACKET)
+        write_packed_packets(channel, id, data->buffer, data->buffer_length);
+    else
+        write_data_packets(channel, id, data->buffer, data->buffer_length);
+    timing_profile_end(TIMING_PROFILE_WRITE, start);
+    s->telemetry.frames_sent++;
 
-    // check if data meets the transmit condition
-    return !should_transmit(*below_thd, thd_event);
+    // a data request has been served
+    pthread_mutex_lock(&data_requests_lock);
+    if(channel->data_requests > 0)
+        channel->data_requests--;
+    pthread_mutex_unlock(&data_requests_lock);
+    return true;
 }
 
-static void sender_run(void) {
-    static int16_t buffer[PROCESSING_DATA_MAX_LENGTH];
-    int buffer_length;
-    bool below_threshold;
+static bool has_data_requests(const struct sensor *s) {
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++)
+        if(s->channels[i].data_requests > 0)
+            return true;
+    return false;
+}
 
+static int sender_run_sensor(struct sensor *s) {
     // if timing is on-demand and there are no data requests, do nothing
-    if(transmit_timing == TOF2CAN_TIMING_ON_DEMAND && data_requests == 0)
-        return;
+    if(s->transmit_timing == TOF2CAN_TIMING_ON_DEMAND &&
+       !has_data_requests(s))
+        return 1;
 
     // try to retrieve data
-    if(retrieve_data(buffer, &buffer_length, &below_threshold))
-        return;
+    const struct processing_frame *frame = processing_acquire_data(s->index);
+    if(!frame)
+        return 1;
 
-    // send CAN message(s)
+    pthread_mutex_lock(&transmit_lock);
+    timing_begin(TIMING_STAGE_TRANSMIT);
     board_userled(BOARD_RED_LED, true);
-    if(buffer_length == 1)
-        write_single_sample(buffer[0], below_threshold);
-    else
-        write_data_packets(buffer, buffer_length);
+
+    // batches are sent in the slot of the sensor
+    tx_staged.sensor_id = s->id;
+
+    uint64_t captured_us;
+    tx_staged.timestamps = s->timestamps;
+    tx_staged.synced     = sync_get_time(frame->captured, &captured_us);
+    tx_staged.timestamp  = captured_us / TOF2CAN_TIMESTAMP_UNIT_US;
+
+    // transmit the data of each channel, if needed
+    bool transmitted = false;
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++)
+        transmitted |= transmit_channel(s, i, &frame->channels[i]);
+
     board_userled(BOARD_RED_LED, false);
+    timing_end(TIMING_STAGE_TRANSMIT, transmitted);
+    pthread_mutex_unlock(&transmit_lock);
+
+    processing_release_data(s->index);
+    return 0;
+}
+
+// Returns 1 if no sensor had data to send
+static int sender_run(void) {
+    int err = 1;
+    for(int i = 0; i < tof_sensor_count; i++)
+        if(!sender_run_sensor(&sensors[i]))
+            err = 0;
+    return err;
+}
+
+// Waits for data to send, at most 'timeout_ms' (-1 = no limit)
+static void sender_wait(int timeout_ms) {
+    if(timeout_ms < 0) {
+        sem_wait(&sender_sem);
+        return;
+    }
+
+    struct timespec timeout;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec  += timeout_ms / 1000;
+    timeout.tv_nsec += (timeout_ms % 1000) * 1000000;
+    if(timeout.tv_nsec >= 1000000000) {
+        timeout.tv_sec  += 1;
+        timeout.tv_nsec -= 1000000000;
+    }
+    sem_timedwait(&sender_sem, &timeout);
+}
+
+static void *sender_main(void *arg) {
+    int telemetry_wait_ms = -1;
+    while(true) {
+        int timeout_ms = telemetry_wait_ms;
+
+        // retry writing queued messages when the TX FIFO has room, or
+        // when their slot begins
+        if(tx_queue.batch_count > 0 &&
+           (timeout_ms < 0 || timeout_ms > tx_queue.retry_ms))
+            timeout_ms = tx_queue.retry_ms;
+        sender_wait(timeout_ms);
+
+        // send all data that is available
+        while(!sender_run())
+            continue;
+        telemetry_wait_ms = telemetry_run();
+
+        // replies are queued by the receiving task
+        pthread_mutex_lock(&transmit_lock);
+        tx_flush();
+        pthread_mutex_unlock(&transmit_lock);
+    }
+    return NULL;
+}
+
+static int sender_start(void) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SENDER_STACK_SIZE);
+
+    // same priority as the acquiring task
+    struct sched_param param = { .sched_priority = SCHED_PRIORITY_MAX };
+    pthread_attr_setschedparam(&attr, &param);
+
+    sem_init(&sender_sem, 0, 0);
+
+    pthread_t thread;
+    const int err = pthread_create(&thread, &attr, sender_main, NULL);
+    pthread_attr_destroy(&attr);
+
+    if(err) {
+        printf("[CAN-IO] error creating sender thread (err=%d)\n", err);
+        return 1;
+    }
+    return 0;
 }
 
 /* ================================================================== */
 
-static inline void print_bit_timing(int fd) {
+// Returns the baud rate, or 0 if it cannot be read
+static uint32_t print_bit_timing(int fd) {
     struct canioc_bittiming_s bt;
     int ret = ioctl(
         fd, CANIOC_GET_BITTIMING,
@@ -269,16 +1823,21 @@ static inline void print_bit_timing(int fd) {
 
     if(ret < 0) {
         printf("[CAN-IO] bit timing not available\n");
+        return 0;
     } else {
         printf("[CAN-IO] bit timing:\n");
         printf("   Baud: %lu\n", (unsigned long) bt.bt_baud);
         printf("  TSEG1: %u\n", bt.bt_tseg1);
         printf("  TSEG2: %u\n", bt.bt_tseg2);
         printf("    SJW: %u\n", bt.bt_sjw);
+        return bt.bt_baud;
     }
 }
 
 int can_io_init(void) {
+    for(int i = 0; i < TOF_MAX_SENSORS; i++)
+        sensors[i].index = i;
+
     // open CAN device in read-write mode
     can_fd = open("/dev/can0", O_RDWR | O_NONBLOCK);
     if(can_fd < 0) {
@@ -288,54 +1847,312 @@ int can_io_init(void) {
     printf("[CAN-IO] /dev/can0 opened\n");
 
     // print bit timing information
-    print_bit_timing(can_fd);
+    uint32_t baud = print_bit_timing(can_fd);
+    if(baud == 0)
+        baud = DEFAULT_BAUD;
+    frame_cycles = FRAME_MAX_BITS * (up_perf_getfreq() / baud);
+
+    // opening the device resets the acceptance filters
+    update_filters();
+
+    // start sending data in a separate thread
+    if(sender_start()) {
+        close(can_fd);
+        return 1;
+    }
+    return 0;
+}
+
+static int restore_config(struct sensor *s) {
+    static struct stored_config stored;
+    const int err = storage_read(
+        STORAGE_KEY_CONFIG(s->index), &stored, sizeof(stored)
+    );
+    if(err || !stored.valid) {
+        printf("[CAN-IO] no stored configuration for sensor %d\n", s->index);
+        return 1;
+    }
+
+    printf("[CAN-IO] applying stored configuration of sensor %d\n", s->index);
+    apply_config(s, &stored.config);
+    for(int i = 0; i < stored.ext_count; i++)
+        if(!handle_ext_config(s, &stored.ext[i]))
+            record_ext_config(s, &stored.ext[i]);
     return 0;
 }
 
+int can_io_restore_config(void) {
+    int err = 1;
+    for(int i = 0; i < tof_sensor_count; i++)
+        if(!restore_config(&sensors[i]))
+            err = 0;
+    return err;
+}
+
+void can_io_print_filters(void) {
+    static const char *names[] = {
+        [FILTER_MODE_OPEN]   = "open (all messages received)",
+        [FILTER_MODE_NARROW] = "narrow",
+        [FILTER_MODE_WIDE]   = "wide (too many IDs for narrow filters)"
+    };
+    printf("acceptance filters: %s\n", names[filter_mode]);
+
+    // read the filters back from the controller
+    for(int i = 0; ; i++) {
+        uint16_t id, mask;
+        const int ret = stm32l4_can_getfilter(i, &id, &mask);
+        if(ret == -ERANGE)
+            break;
+        if(ret == 0)
+            printf("  %2d: ID 0x%03x, mask 0x%03x\n", i, id, mask);
+    }
+
+    const struct can_io_rx_stats stats = can_io_rx_stats;
+    printf(
+        "messages received: %lu (%lu not addressed to any sensor)\n",
+        (unsigned long) stats.received, (unsigned long) stats.ignored
+    );
+    printf(
+        "receive overruns:  %lu\n", (unsigned long) stats.overruns
+    );
+}
+
+void can_io_print_tx_stats(void) {
+    const struct can_io_tx_stats stats = can_io_tx_stats;
+
+    printf(
+        "batches sent:     %lu (%lu messages)\n",
+        (unsigned long) stats.batches, (unsigned long) stats.frames
+    );
+    printf(
+        "batches dropped:  %lu (%lu messages)\n",
+        (unsigned long) stats.dropped_batches,
+        (unsigned long) stats.dropped_frames
+    );
+    printf(
+        "write errors:     %lu\n", (unsigned long) stats.write_errors
+    );
+    printf(
+        "late messages:    %lu (sent over %lu ms after being queued)\n",
+        (unsigned long) stats.late_frames, (unsigned long) get_deadline_ms()
+    );
+    printf(
+        "max queued:       %lu of %d messages\n",
+        (unsigned long) stats.max_queued_frames, TX_QUEUE_FRAMES
+    );
+
+    pthread_mutex_lock(&slots_lock);
+    const bool enabled = slots.enabled;
+    const int  count   = slots.count;
+    const unsigned long slot_us = slots.length / (up_perf_getfreq() / 1000000);
+    pthread_mutex_unlock(&slots_lock);
+
+    if(enabled)
+        printf("transmit slots:   %d of %lu us", count, slot_us);
+    else
+        printf("transmit slots:   off");
+    printf(" (%lu beacons received)\n", (unsigned long) stats.beacons);
+}
+
 void can_io_run(void) {
     receiver_run();
-    sender_run();
 }
 
-int can_io_set_sensor_id(int id) {
+void can_io_notify(void) {
+    sem_post(&sender_sem);
+}
+
+int can_io_wait(int timeout_ms) {
+    struct pollfd fds = {
+        .fd     = can_fd,
+        .events = POLLIN
+    };
+
+    const struct timespec timeout = {
+        .tv_sec  = timeout_ms / 1000,
+        .tv_nsec = (timeout_ms % 1000) * 1000000
+    };
+
+    // unblock all signals while waiting, so that they interrupt the wait
+    sigset_t sigmask;
+    sigemptyset(&sigmask);
+
+    return ppoll(&fds, 1, &timeout, &sigmask);
+}
+
+static inline bool is_sensor_valid(int sensor) {
+    return (sensor >= 0 && sensor < tof_sensor_count);
+}
+
+int can_io_set_sensor_id(int sensor, int id) {
     int err = 0;
 
-    if(id > 0 && id < TOF2CAN_MAX_SENSOR_COUNT)
-        sensor_id = id;
+    // IDs must be unique among all sensors and their channels
+    pthread_mutex_lock(&transmit_lock);
+    if(sensor >= 0 && sensor < TOF_MAX_SENSORS &&
+       id > 0 && id < TOF2CAN_MAX_SENSOR_COUNT &&
+       (sensors[sensor].id == id || !is_id_used(id))) {
+        sensors[sensor].id = id;
+        update_filters();
+    } else {
+        err = 1;
+    }
+    pthread_mutex_unlock(&transmit_lock);
+
+    printf(
+        "[CAN-IO] setting ID of sensor %d to %d (err=%d)\n",
+        sensor, id, err
+    );
+    return err;
+}
+
+int can_io_set_transmit_timing(int sensor, int timing) {
+    int err = 0;
+    pthread_mutex_lock(&transmit_lock);
+    if(is_sensor_valid(sensor) && timing >= 0 && timing < 2)
+        sensors[sensor].transmit_timing = timing;
     else
         err = 1;
+    pthread_mutex_unlock(&transmit_lock);
 
     printf(
-        "[CAN-IO] setting sensor ID to %d (err=%d)\n",
-        id, err
+        "[CAN-IO] setting transmit timing of sensor %d to %d (err=%d)\n",
+        sensor, timing, err
     );
     return err;
 }
 
-int can_io_set_transmit_timing(int timing) {
+int can_io_set_transmit_condition(int sensor, int channel, int condition) {
     int err = 0;
-    if(timing >= 0 && timing < 2)
-        transmit_timing = timing;
+    pthread_mutex_lock(&transmit_lock);
+    if(is_sensor_valid(sensor) &&
+       channel >= 0 && channel < PROCESSING_CHANNEL_COUNT &&
+       condition >= 0 && condition < 4)
+        sensors[sensor].channels[channel].transmit_condition = condition;
     else
         err = 1;
+    pthread_mutex_unlock(&transmit_lock);
+
+    printf(
+        "[CAN-IO] setting transmit condition of sensor %d channel %d "
+        "to %d (err=%d)\n",
+        sensor, channel, condition, err
+    );
+    return err;
+}
+
+int can_io_set_channel_id(int sensor, int channel, int id) {
+    int err = 0;
+
+    // channel 0 always uses the sensor ID, ID=0 disables the channel
+    pthread_mutex_lock(&transmit_lock);
+    if(is_sensor_valid(sensor) &&
+       channel > 0 && channel < PROCESSING_CHANNEL_COUNT &&
+       id >= 0 && id < TOF2CAN_MAX_SENSOR_COUNT &&
+       (id == 0 || id == sensors[sensor].channels[channel].id ||
+        !is_id_used(id))) {
+        struct channel *c = &sensors[sensor].channels[channel];
+
+        pthread_mutex_lock(&data_requests_lock);
+        c->id = id;
+        c->data_requests = 0;
+        pthread_mutex_unlock(&data_requests_lock);
+
+        // start again from a keyframe
+        c->reference.valid = false;
+
+        update_filters();
+    } else {
+        err = 1;
+    }
+    pthread_mutex_unlock(&transmit_lock);
 
     printf(
-        "[CAN-IO] setting transmit timing to %d (err=%d)\n",
-        timing, err
+        "[CAN-IO] setting ID of sensor %d channel %d to %d (err=%d)\n",
+        sensor, channel, id, err
     );
     return err;
 }
 
-int can_io_set_transmit_condition(int condition) {
+int can_io_set_data_encoding(int sensor, int encoding) {
     int err = 0;
-    if(condition >= 0 && condition < 4)
-        transmit_condition = condition;
+    pthread_mutex_lock(&transmit_lock);
+    if(is_sensor_valid(sensor) && encoding >= 0 && encoding < 2)
+        sensors[sensor].data_encoding = encoding;
     else
         err = 1;
+    pthread_mutex_unlock(&transmit_lock);
+
+    printf(
+        "[CAN-IO] setting data encoding of sensor %d to %d (err=%d)\n",
+        sensor, encoding, err
+    );
+    return err;
+}
+
+int can_io_set_delta(int sensor, bool enabled, int deadband,
+                     int keyframe_interval) {
+    int err = 0;
+    pthread_mutex_lock(&transmit_lock);
+    if(is_sensor_valid(sensor) && deadband >= 0 && keyframe_interval >= 1) {
+        struct sensor *s = &sensors[sensor];
+        s->delta.enabled           = enabled;
+        s->delta.deadband          = deadband;
+        s->delta.keyframe_interval = keyframe_interval;
+
+        // start again from a keyframe
+        for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++)
+            s->channels[i].reference.valid = false;
+    } else {
+        err = 1;
+    }
+    pthread_mutex_unlock(&transmit_lock);
+
+    printf(
+        "[CAN-IO] setting delta transmission of sensor %d to %d "
+        "(deadband=%d, keyframe interval=%d, err=%d)\n",
+        sensor, enabled, deadband, keyframe_interval, err
+    );
+    return err;
+}
+
+int can_io_set_telemetry(int sensor, int interval_ms) {
+    int err = 1;
+    if(is_sensor_valid(sensor) && interval_ms >= 0) {
+        struct sensor *s = &sensors[sensor];
+
+        const uint32_t now = get_ms();
+        pthread_mutex_lock(&transmit_lock);
+        s->telemetry.last_ms         = now;
+        s->telemetry.last_loop_count = main_loop_count;
+        s->telemetry.next_ms         = now + interval_ms;
+        s->telemetry.interval_ms     = interval_ms;
+        pthread_mutex_unlock(&transmit_lock);
+        err = 0;
+
+        // the sender computes when the next report is due
+        can_io_notify();
+    }
+
+    printf(
+        "[CAN-IO] setting telemetry interval of sensor %d to %d ms "
+        "(err=%d)\n", sensor, interval_ms, err
+    );
+    return err;
+}
+
+int can_io_set_timestamps(int sensor, bool enabled) {
+    int err = 1;
+    if(is_sensor_valid(sensor)) {
+        pthread_mutex_lock(&transmit_lock);
+        sensors[sensor].timestamps = enabled;
+        pthread_mutex_unlock(&transmit_lock);
+        err = 0;
+    }
 
     printf(
-        "[CAN-IO] setting transmit condition to %d (err=%d)\n",
-        condition, err
+        "[CAN-IO] setting timestamps of sensor %d to %d (err=%d)\n",
+        sensor, enabled, err
     );
     return err;
 }
@@ -18,3 +18,43 @@ _Static_assert(
     sizeof(struct tof2can_data_packet) == TOF2CAN_DATA_PACKET_SIZE,
     "size of struct tof2can_data_packet is incorrect"
 );
+
+_Static_assert(
+    sizeof(struct tof2can_packed_packet) == TOF2CAN_PACKED_PACKET_SIZE,
+    "size of struct tof2can_packed_packet is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_ext_config) == TOF2CAN_EXT_CONFIG_SIZE,
+    "size of struct tof2can_ext_config is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_storage) == TOF2CAN_STORAGE_SIZE,
+    "size of struct tof2can_storage is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_telemetry) == TOF2CAN_TELEMETRY_SIZE,
+    "size of struct tof2can_telemetry is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_profile) == TOF2CAN_PROFILE_SIZE,
+    "size of struct tof2can_profile is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_beacon) == TOF2CAN_BEACON_SIZE,
+    "size of struct tof2can_beacon is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_timestamp) == TOF2CAN_TIMESTAMP_SIZE,
+    "size of struct tof2can_timestamp is incorrect"
+);
+
+_Static_assert(
+    sizeof(struct tof2can_sync) == TOF2CAN_SYNC_SIZE,
+    "size of struct tof2can_sync is incorrect"
+);
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "decode.h"
+
+#include <string.h>
+
+// The sensor sends 32-bit big-endian words, while the decoded data is
+// little-endian: each word is byte-swapped (a single REV instruction on
+// Cortex-M4).
+static inline uint32_t read_word(const uint8_t *buffer, int offset) {
+    uint32_t word;
+    memcpy(&word, &buffer[offset], sizeof(word));
+    return __builtin_bswap32(word);
+}
+
+// Copies a block's data, byte-swapping each word
+static inline void copy_block(void *dest, const uint8_t *buffer,
+                              int offset, int size) {
+    uint8_t *d = dest;
+    for(int i = 0; i < size; i += 4) {
+        const uint32_t word = read_word(buffer, offset + i);
+        memcpy(&d[i], &word, sizeof(word));
+    }
+}
+
+// Returns the byte at 'index' of the byte-swapped buffer
+static inline uint8_t swapped_byte(const uint8_t *buffer, int index) {
+    return buffer[(index & ~3) | (3 - (index & 3))];
+}
+
+/*
+ * The resolution is a constant in each call, so that the compiler can
+ * generate a version of this function for each resolution.
+ */
+static inline __attribute__((always_inline))
+int decode(const uint8_t *buffer, int size, const int zones,
+           struct decode_output *output) {
+    const int elements = zones * VL53L5CX_NB_TARGET_PER_ZONE;
+
+    bool has_distance   = false;
+    bool has_sigma      = false;
+    bool has_signal     = false;
+    bool has_nb_targets = false;
+
+    // start at position 16 to skip headers (same as ULD)
+    for(int i = 16; i < size; i += 4) {
+        const union Block_header bh = { .bytes = read_word(buffer, i) };
+
+        const int block_size = (bh.type > 0x1 && bh.type < 0xd)
+            ? bh.type * bh.size
+            : bh.size;
+
+        void *dest = NULL;
+        int   dest_size = 0;
+        switch(bh.idx) {
+            case VL53L5CX_DISTANCE_IDX:
+                dest = output->distance_mm;
+                dest_size = elements * sizeof(int16_t);
+                has_distance = true;
+                break;
+
+            case VL53L5CX_TARGET_STATUS_IDX:
+                dest = output->target_status;
+                dest_size = elements * sizeof(uint8_t);
+                break;
+
+            case VL53L5CX_RANGE_SIGMA_MM_IDX:
+                dest = output->range_sigma_mm;
+                dest_size = elements * sizeof(uint16_t);
+                has_sigma = true;
+                break;
+
+            case VL53L5CX_SIGNAL_RATE_IDX:
+                dest = output->signal_per_spad;
+                dest_size = elements * sizeof(uint32_t);
+                has_signal = true;
+                break;
+
+            case VL53L5CX_NB_TARGET_DETECTED_IDX:
+                dest = output->nb_target_detected;
+                dest_size = zones * sizeof(uint8_t);
+                has_nb_targets = true;
+                break;
+        }
+
+        if(dest) {
+            // the block must fit both in the frame and in the output
+            if(block_size != dest_size || i + 4 + block_size > size)
+                return 1;
+            copy_block(dest, buffer, i + 4, block_size);
+        }
+        i += block_size;
+    }
+
+    // check if header and footer IDs match (detects corrupted frames)
+    const uint16_t header_id = (
+        swapped_byte(buffer, 0x8) << 8 | swapped_byte(buffer, 0x9)
+    );
+    const uint16_t footer_id = (
+        swapped_byte(buffer, size - 4) << 8 |
+        swapped_byte(buffer, size - 3)
+    );
+    if(header_id != footer_id)
+        return 1;
+
+    #ifndef VL53L5CX_USE_RAW_FORMAT
+        // convert data into their real format
+        if(has_distance) {
+            for(int i = 0; i < elements; i++) {
+                const int distance = output->distance_mm[i] / 4;
+                output->distance_mm[i] = (distance < 0 ? 0 : distance);
+            }
+        }
+        if(has_sigma) {
+            for(int i = 0; i < elements; i++)
+                output->range_sigma_mm[i] /= 128;
+        }
+        if(has_signal) {
+            for(int i = 0; i < elements; i++)
+                output->signal_per_spad[i] /= 2048;
+        }
+
+        // set target status to 255 if no target is detected in the zone
+        if(has_nb_targets) {
+            for(int z = 0; z < zones; z++) {
+                if(output->nb_target_detected[z] != 0)
+                    continue;
+
+                for(int t = 0; t < VL53L5CX_NB_TARGET_PER_ZONE; t++) {
+                    const int i = z * VL53L5CX_NB_TARGET_PER_ZONE + t;
+                    output->target_status[i] = 255;
+                }
+            }
+        }
+    #endif
+    return 0;
+}
+
+int decode_frame(const uint8_t *buffer, int size, int resolution,
+                 struct decode_output *output) {
+    if(size < 24 || size % 4 != 0)
+        return 1;
+
+    switch(resolution) {
+        case VL53L5CX_RESOLUTION_4X4:
+            return decode(buffer, size, VL53L5CX_RESOLUTION_4X4, output);
+        case VL53L5CX_RESOLUTION_8X8:
+            return decode(buffer, size, VL53L5CX_RESOLUTION_8X8, output);
+    }
+    return 1;
+}
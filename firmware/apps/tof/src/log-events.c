@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "log.h"
+
+#include <stdio.h>
+
+const struct log_event_info log_events[LOG_EVENT_COUNT] = {
+    [LOG_EVENT_NO_VALID_DATA] = {
+        LOG_LEVEL_INFO, false,
+        "[Processing] no valid data point was found (sensor %d)"
+    },
+    [LOG_EVENT_READY_CHECK_ERROR] = {
+        LOG_LEVEL_ERROR, false,
+        "[ToF] error in vl53l5cx_check_data_ready (sensor %d)"
+    },
+    [LOG_EVENT_READ_ERROR] = {
+        LOG_LEVEL_ERROR, false,
+        "[ToF] error reading ranging data (sensor %d)"
+    },
+    [LOG_EVENT_CORRUPTED_FRAME] = {
+        LOG_LEVEL_ERROR, false,
+        "[ToF] corrupted frame (sensor %d)"
+    },
+    [LOG_EVENT_CAN_WRITE_ERROR] = {
+        LOG_LEVEL_ERROR, false,
+        "[CAN-IO] error writing to CAN device (ID 0x%03x, errno %d)"
+    },
+    [LOG_EVENT_DUMP_BEGIN] = {
+        LOG_LEVEL_DEBUG, false,
+        "=== DATA DUMP (sensor %d, channel %d) ==="
+    },
+    [LOG_EVENT_DUMP_ROW] = {
+        LOG_LEVEL_DEBUG, true,
+        ""
+    },
+    [LOG_EVENT_DUMP_DATA] = {
+        LOG_LEVEL_DEBUG, true,
+        "Distance data: "
+    },
+    [LOG_EVENT_DUMP_THRESHOLD] = {
+        LOG_LEVEL_DEBUG, false,
+        "Below threshold: %d, threshold event: %d"
+    }
+};
+
+int log_format(char *buffer, int size, int event,
+               const int16_t *args, int nargs) {
+    if(event < 0 || event >= LOG_EVENT_COUNT)
+        return snprintf(buffer, size, "[Log] unknown event %d", event);
+    const struct log_event_info *info = &log_events[event];
+
+    if(!info->list) {
+        // missing arguments are printed as 0, extra ones are ignored
+        int values[LOG_MAX_ARGS] = { 0 };
+        for(int i = 0; i < nargs && i < LOG_MAX_ARGS; i++)
+            values[i] = args[i];
+
+        return snprintf(
+            buffer, size, info->format,
+            values[0], values[1], values[2], values[3],
+            values[4], values[5], values[6], values[7]
+        );
+    }
+
+    int len = snprintf(buffer, size, "%s", info->format);
+    for(int i = 0; i < nargs && len < size; i++)
+        len += snprintf(&buffer[len], size - len, "%d, ", args[i]);
+    return len;
+}
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <nuttx/arch.h>
+
+// must be a power of 2
+#define LOG_RING_SIZE 64
+
+// below the NSH console, so printing never delays the shell
+#define LOG_TASK_PRIORITY   50
+#define LOG_TASK_STACK_SIZE 2048
+
+#define LOG_POLL_MS 20
+
+volatile int log_level = LOG_LEVEL_INFO;
+
+static volatile int output = LOG_OUTPUT_TEXT;
+
+// Each writer reserves a slot by incrementing 'head', then publishes
+// the entry by setting the sequence number of the slot to its position
+// in the ring plus one. The reader compares sequence numbers to tell
+// complete entries from those being written or already overwritten.
+static struct {
+    volatile uint32_t sequence;
+    struct log_entry entry;
+} ring[LOG_RING_SIZE];
+
+static uint32_t head;
+static uint32_t tail; // next entry to print
+
+static uint32_t written;
+static uint32_t dropped;
+
+// held by the reader, either the log task or 'log_dump'
+static pthread_mutex_t reader_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t get_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void log_write(int event, const int16_t *args, int nargs) {
+    if(!log_enabled(log_events[event].level))
+        return;
+    if(nargs > LOG_MAX_ARGS)
+        nargs = LOG_MAX_ARGS;
+
+    const uint32_t position = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+    typeof(ring[0]) *slot = &ring[position % LOG_RING_SIZE];
+
+    // the slot is invalid until the entry is complete
+    __atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->entry.time_ms = get_ms();
+    slot->entry.cycles  = up_perf_gettime();
+    slot->entry.event   = event;
+    slot->entry.nargs   = nargs;
+    memcpy(slot->entry.args, args, nargs * sizeof(int16_t));
+
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&written, 1, __ATOMIC_RELAXED);
+}
+
+// Copies the entry at 'tail' and returns 0, or returns 1 if it is not
+// complete yet. Entries overwritten before being read are dropped.
+static int read_entry(struct log_entry *entry) {
+    while(true) {
+        const uint32_t last = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+        if(last - tail > LOG_RING_SIZE) {
+            dropped += last - LOG_RING_SIZE - tail;
+            tail = last - LOG_RING_SIZE;
+        }
+        if(tail == last)
+            return 1;
+
+        typeof(ring[0]) *slot = &ring[tail % LOG_RING_SIZE];
+        if(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != tail + 1)
+            return 1;
+
+        *entry = slot->entry;
+
+        // if a writer took the slot while copying, try again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == tail + 1)
+            break;
+    }
+    tail++;
+    return 0;
+}
+
+static void print_entry(const struct log_entry *entry, bool raw) {
+    if(raw) {
+        printf(
+            "@L %lx %lx %x", (unsigned long) entry->time_ms,
+            (unsigned long) entry->cycles, entry->event
+        );
+        for(int i = 0; i < entry->nargs; i++)
+            printf(" %x", (uint16_t) entry->args[i]);
+        printf("\n");
+    } else {
+        char text[128];
+        log_format(
+            text, sizeof(text), entry->event, entry->args, entry->nargs
+        );
+        puts(text);
+    }
+}
+
+static void drain(bool raw) {
+    pthread_mutex_lock(&reader_lock);
+
+    const uint32_t dropped_before = dropped;
+
+    struct log_entry entry;
+    while(!read_entry(&entry))
+        print_entry(&entry, raw);
+
+    if(dropped != dropped_before) {
+        const unsigned long count = dropped - dropped_before;
+        if(raw)
+            printf("@D %lx\n", count);
+        else
+            printf("[Log] %lu messages dropped\n", count);
+    }
+    pthread_mutex_unlock(&reader_lock);
+}
+
+static void *log_main(void *arg) {
+    while(true) {
+        const int mode = output;
+        if(mode != LOG_OUTPUT_HOLD)
+            drain(mode == LOG_OUTPUT_RAW);
+        usleep(LOG_POLL_MS * 1000);
+    }
+    return NULL;
+}
+
+int log_init(void) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, LOG_TASK_STACK_SIZE);
+
+    struct sched_param param = { .sched_priority = LOG_TASK_PRIORITY };
+    pthread_attr_setschedparam(&attr, &param);
+
+    pthread_t thread;
+    const int err = pthread_create(&thread, &attr, log_main, NULL);
+    pthread_attr_destroy(&attr);
+
+    if(err) {
+        printf("[Log] error creating log task (err=%d)\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+void log_set_output(int mode) {
+    // the formatter needs the cycle counter frequency to convert cycles
+    if(mode == LOG_OUTPUT_RAW)
+        printf("@F %lx\n", (unsigned long) up_perf_getfreq());
+    output = mode;
+}
+
+void log_dump(void) {
+    drain(false);
+}
+
+void log_print_stats(void) {
+    static const char *levels[] = { "error", "info", "debug" };
+    static const char *outputs[] = { "text", "raw", "hold" };
+
+    printf("level:   %s\n", levels[log_level]);
+    printf("output:  %s\n", outputs[output]);
+    printf("written: %lu\n", (unsigned long) written);
+    printf("dropped: %lu\n", (unsigned long) dropped);
+}
@@ -24,26 +24,110 @@
 #include "processing.h"
 #include "can-io.h"
 #include "tof.h"
+#include "timing.h"
+#include "log.h"
+#include "sync.h"
 
-bool debug_flag = false;
+#define WAKEUP_POLL  0
+#define WAKEUP_EVENT 1
+
+// safety net, in case a data-ready interrupt gets lost
+#define WAIT_TIMEOUT_MS 100
+
+volatile uint32_t main_loop_count;
+
+static int wakeup_mode;
+static volatile int requested_wakeup_mode = WAKEUP_EVENT;
+
+// CAN ID of each sensor, in the order of their LPn pins (0 = not set)
+static int sensor_ids[TOF_MAX_SENSORS];
+static int sensor_count = 1;
+
+// sensor read first in the next iteration of the main loop
+static int next_sensor;
 
 static void init(void) {
-    while(tof_init())
+    if(log_init())
+        puts("[Main] log task not started: messages are held");
+
+    processing_init();
+
+    while(tof_init(sensor_count))
         puts("[Main] ToF initialization failed: retrying");
 
     while(can_io_init())
         puts("[Main] CAN IO initialization failed: retrying");
+
+    for(int i = 0; i < sensor_count; i++)
+        if(sensor_ids[i] != 0)
+            can_io_set_sensor_id(i, sensor_ids[i]);
+}
+
+static void set_wakeup_mode(int mode) {
+    // the interrupt is registered to the calling task, so this function
+    // must be called by the task running the main loop
+    if(tof_interrupt_enable(mode == WAKEUP_EVENT)) {
+        puts("[Main] falling back to polling the sensor");
+        mode = WAKEUP_POLL;
+    }
+
+    wakeup_mode = mode;
+    requested_wakeup_mode = mode;
+    memset(&tof_stats, 0, sizeof(tof_stats));
+}
+
+static void wait_for_event(void) {
+    // in polling mode, never block
+    if(wakeup_mode == WAKEUP_POLL)
+        return;
+
+    // if a frame is already waiting to be read, do not block
+    if(tof_interrupt_pending())
+        return;
+
+    // block until a frame or a CAN message is available
+    can_io_wait(WAIT_TIMEOUT_MS);
+}
+
+// Reads the sensors with a new frame, starting from a different sensor
+// each time so that none of them is starved. Returns 1 if no frame was
+// acquired.
+static int acquire_frames(void) {
+    int err = 1;
+    for(int i = 0; i < tof_sensor_count; i++) {
+        const int sensor = (next_sensor + i) % tof_sensor_count;
+        if(!processing_run(sensor))
+            err = 0;
+    }
+
+    next_sensor = (next_sensor + 1) % tof_sensor_count;
+    return err;
 }
 
 static int task_main(int argc, char *argv[]) {
     board_userled(BOARD_GREEN_LED, true);
     board_userled(BOARD_RED_LED, true);
     init();
+    set_wakeup_mode(requested_wakeup_mode);
+    can_io_restore_config();
+    timing_reset();
     board_userled(BOARD_RED_LED, false);
 
     while(true) {
-        processing_run();
+        if(requested_wakeup_mode != wakeup_mode)
+            set_wakeup_mode(requested_wakeup_mode);
+
+        main_loop_count++;
+        wait_for_event();
+
+        // acquire the next frames while the sender transmits the previous
+        if(!acquire_frames())
+            can_io_notify();
         can_io_run();
+
+        // let the sender run, as this loop never blocks when polling
+        if(wakeup_mode == WAKEUP_POLL)
+            sched_yield();
     }
     return EXIT_SUCCESS;
 }
@@ -55,19 +139,42 @@ static int task_main(int argc, char *argv[]) {
 static void print_help(const char *program) {
     printf("Usage: %s [command]\n\n", program);
     puts("Command can be:");
-    puts("  start           start the app");
-    puts("  debug           enable debugging info");
+    puts("  start [id...]   start the app, with the CAN ID of each sensor");
+    puts("  debug [level]   set log level: error, info or debug (default)");
+    puts("  wakeup <mode>   wake up on 'event' (INT pin, CAN) or 'poll'");
+    puts("  stats           print sensor readout counters");
+    puts("  i2c <hz> [size] set I2C frequency and chunk size (0=no limit)");
+    puts("  outputs         print bytes read per frame by each output profile");
+    puts("  boot [clear]    print sensor boot phases (or clear cached data)");
+    puts("  boot i2c <hz>   set I2C frequency of firmware upload (0=as i2c)");
+    puts("  timing [reset]  print (or reset) stage timing and cycle profile");
+    puts("  profile         print cycle profile of the steps of each frame");
+    puts("  reconfig        print configuration latency");
+    puts("  filters         print CAN acceptance filters");
+    puts("  tx [reset]      print (or reset) CAN transmit queue counters");
+    puts("  sync            print bus time synchronization state");
+    puts("  log [mode]      print log counters, or set text/raw/hold, or dump");
     puts("  help            prints this help message");
 }
 
-// TODO take sensor IDs as input
-static int cmd_start(void) {
+static int cmd_start(int count, char *ids[]) {
     static bool started = false;
     if(started) {
         puts("[Main] already started");
         return EXIT_FAILURE;
     }
 
+    // each ID is given to the sensor driven by the matching LPn pin
+    if(count > TOF_MAX_SENSORS) {
+        printf("[Main] at most %d sensors are supported\n", TOF_MAX_SENSORS);
+        return EXIT_FAILURE;
+    }
+
+    for(int i = 0; i < count; i++)
+        sensor_ids[i] = atoi(ids[i]);
+    if(count > 0)
+        sensor_count = count;
+
     int id = task_create(
         "tof-task", SCHED_PRIORITY_MAX, 4096,
         task_main, NULL
@@ -76,8 +183,190 @@ static int cmd_start(void) {
     return (id == 0 ? EXIT_FAILURE : EXIT_SUCCESS);
 }
 
-static int cmd_debug(void) {
-    // TODO
+static int cmd_debug(const char *level) {
+    static const char *names[] = { "error", "info", "debug" };
+
+    if(!level) {
+        log_level = LOG_LEVEL_DEBUG;
+        return EXIT_SUCCESS;
+    }
+
+    for(int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if(!strcmp(level, names[i])) {
+            log_level = i;
+            return EXIT_SUCCESS;
+        }
+    }
+    return EXIT_FAILURE;
+}
+
+static int cmd_wakeup(const char *mode) {
+    if(mode && !strcmp(mode, "poll"))
+        requested_wakeup_mode = WAKEUP_POLL;
+    else if(mode && !strcmp(mode, "event"))
+        requested_wakeup_mode = WAKEUP_EVENT;
+    else
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+static int cmd_stats(void) {
+    const struct tof_stats stats = tof_stats;
+
+    printf("wakeup mode:        %s\n", wakeup_mode ? "event" : "poll");
+    printf("frames read:        %lu\n", (unsigned long) stats.frames);
+    printf("data-ready IRQs:    %lu\n", (unsigned long) stats.interrupts);
+    printf(
+        "data-ready checks:  %lu (%lu without new data)\n",
+        (unsigned long) stats.ready_checks,
+        (unsigned long) stats.ready_misses
+    );
+    printf(
+        "check I2C traffic:  %lu bytes\n",
+        (unsigned long) stats.ready_checks * TOF_READY_CHECK_I2C_BYTES
+    );
+    printf(
+        "frame I2C traffic:  %lu bytes in %lu transactions\n",
+        (unsigned long) stats.frame_i2c_bytes,
+        (unsigned long) stats.frame_i2c_transactions
+    );
+    return EXIT_SUCCESS;
+}
+
+static int cmd_i2c(const char *frequency, const char *chunk_size) {
+    if(!frequency)
+        return EXIT_FAILURE;
+
+    const int err = tof_set_i2c(
+        atoi(frequency), chunk_size ? atoi(chunk_size) : 0
+    );
+    return (err ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+static int cmd_outputs(void) {
+    static const char *names[TOF_OUTPUT_PROFILE_COUNT] = {
+        "distance, status",
+        "distance, status, sigma",
+        "distance, status, signal",
+        "distance, status, sigma, signal"
+    };
+
+    for(int sensor = 0; sensor < tof_sensor_count; sensor++) {
+        printf("sensor %d:\n", sensor);
+
+        const int active = tof_get_outputs(sensor);
+        for(int i = 0; i < TOF_OUTPUT_PROFILE_COUNT; i++) {
+            printf(
+                "%c %-32s %4d bytes per frame\n",
+                i == active ? '*' : ' ', names[i],
+                tof_get_frame_size(sensor, i)
+            );
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+static int cmd_boot(const char *arg, const char *frequency) {
+    if(arg && !strcmp(arg, "clear"))
+        return (tof_clear_boot_cache() ? EXIT_FAILURE : EXIT_SUCCESS);
+
+    if(arg && !strcmp(arg, "i2c")) {
+        if(!frequency)
+            return EXIT_FAILURE;
+        const int err = tof_set_boot_i2c(atoi(frequency));
+        return (err ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    static const char *names[TOF_BOOT_PHASE_COUNT] = {
+        [TOF_BOOT_PHASE_RESET]         = "reset",
+        [TOF_BOOT_PHASE_DETECT]        = "detect",
+        [TOF_BOOT_PHASE_WARM_CHECK]    = "warm check",
+        [TOF_BOOT_PHASE_REBOOT]        = "reboot",
+        [TOF_BOOT_PHASE_UPLOAD]        = "firmware upload",
+        [TOF_BOOT_PHASE_CALIBRATION]   = "calibration",
+        [TOF_BOOT_PHASE_CONFIGURATION] = "configuration",
+        [TOF_BOOT_PHASE_SETUP]         = "setup"
+    };
+
+    const struct tof_boot_stats stats = tof_boot_stats;
+    printf(
+        "%s boot, offset data %s\n",
+        stats.warm ? "warm" : "cold",
+        stats.offset_cached || stats.warm ? "cached" : "read from NVM"
+    );
+    for(int i = 0; i < TOF_BOOT_PHASE_COUNT; i++) {
+        printf(
+            "  %-16s %6lu ms\n",
+            names[i], (unsigned long) stats.phase_ms[i]
+        );
+    }
+    printf("  %-16s %6lu ms\n", "total", (unsigned long) stats.total_ms);
+    return EXIT_SUCCESS;
+}
+
+static int cmd_timing(const char *arg) {
+    if(arg && !strcmp(arg, "reset"))
+        timing_reset();
+    else
+        timing_print();
+    return EXIT_SUCCESS;
+}
+
+static int cmd_profile(void) {
+    timing_profile_print();
+    return EXIT_SUCCESS;
+}
+
+static int cmd_reconfig(void) {
+    static const char *names[2] = {
+        [CAN_IO_RECONFIG_IN_PLACE] = "in place",
+        [CAN_IO_RECONFIG_RESTART]  = "restart"
+    };
+
+    const struct can_io_reconfig_stats stats = can_io_reconfig_stats;
+    for(int i = 0; i < 2; i++) {
+        const struct can_io_reconfig_latency *latency = &stats.latency[i];
+        printf(
+            "%-9s %lu times, last %lu us, max %lu us\n",
+            names[i], (unsigned long) latency->count,
+            (unsigned long) latency->last_us,
+            (unsigned long) latency->max_us
+        );
+    }
+    return EXIT_SUCCESS;
+}
+
+static int cmd_filters(void) {
+    can_io_print_filters();
+    return EXIT_SUCCESS;
+}
+
+static int cmd_tx(const char *arg) {
+    if(arg && !strcmp(arg, "reset"))
+        memset(&can_io_tx_stats, 0, sizeof(can_io_tx_stats));
+    else
+        can_io_print_tx_stats();
+    return EXIT_SUCCESS;
+}
+
+static int cmd_sync(void) {
+    sync_print();
+    return EXIT_SUCCESS;
+}
+
+static int cmd_log(const char *arg) {
+    if(!arg)
+        log_print_stats();
+    else if(!strcmp(arg, "text"))
+        log_set_output(LOG_OUTPUT_TEXT);
+    else if(!strcmp(arg, "raw"))
+        log_set_output(LOG_OUTPUT_RAW);
+    else if(!strcmp(arg, "hold"))
+        log_set_output(LOG_OUTPUT_HOLD);
+    else if(!strcmp(arg, "dump"))
+        log_dump();
+    else
+        return EXIT_FAILURE;
     return EXIT_SUCCESS;
 }
 
@@ -89,10 +378,46 @@ int tof_main(int argc, char *argv[]) {
 
     const char *cmd = argv[1];
     if(!strcmp(cmd, "start"))
-        return cmd_start();
+        return cmd_start(argc - 2, &argv[2]);
 
     if(!strcmp(cmd, "debug"))
-        return cmd_debug();
+        return cmd_debug(argc > 2 ? argv[2] : NULL);
+
+    if(!strcmp(cmd, "wakeup"))
+        return cmd_wakeup(argc > 2 ? argv[2] : NULL);
+
+    if(!strcmp(cmd, "stats"))
+        return cmd_stats();
+
+    if(!strcmp(cmd, "i2c"))
+        return cmd_i2c(argc > 2 ? argv[2] : NULL, argc > 3 ? argv[3] : NULL);
+
+    if(!strcmp(cmd, "outputs"))
+        return cmd_outputs();
+
+    if(!strcmp(cmd, "boot"))
+        return cmd_boot(argc > 2 ? argv[2] : NULL, argc > 3 ? argv[3] : NULL);
+
+    if(!strcmp(cmd, "timing"))
+        return cmd_timing(argc > 2 ? argv[2] : NULL);
+
+    if(!strcmp(cmd, "profile"))
+        return cmd_profile();
+
+    if(!strcmp(cmd, "reconfig"))
+        return cmd_reconfig();
+
+    if(!strcmp(cmd, "filters"))
+        return cmd_filters();
+
+    if(!strcmp(cmd, "tx"))
+        return cmd_tx(argc > 2 ? argv[2] : NULL);
+
+    if(!strcmp(cmd, "sync"))
+        return cmd_sync();
+
+    if(!strcmp(cmd, "log"))
+        return cmd_log(argc > 2 ? argv[2] : NULL);
 
     print_help(argv[0]);
     return EXIT_SUCCESS;
@@ -21,9 +21,13 @@
 #include <string.h>
 #include <limits.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "tof2can.h"
 #include "tof.h"
+#include "timing.h"
+#include "selection.h"
+#include "log.h"
 
 #define AREA_MATRIX 0
 #define AREA_COLUMN 1
@@ -35,140 +39,468 @@
 #define SELECTOR_AVERAGE 2
 #define SELECTOR_ALL     3
 
-static struct {
-    bool available;
+// only available through extended settings
+#define SELECTOR_MEDIAN     4
+#define SELECTOR_PERCENTILE 5
 
-    int     buffer_length;
-    int16_t buffer[PROCESSING_DATA_MAX_LENGTH];
+// Each channel processes its own area of the same ToF frame. Channel 0
+// is always enabled, unless explicitly disabled.
+struct channel {
+    bool enabled;
 
+    struct {
+        int x0, y0, x1, y1;
+    } bounds;
+    int result_selector;
+    int percentile;
+    int data_length;
+
+    int threshold;
+    int threshold_delay;
+    int threshold_focus;
+
+    // threshold status
     bool below_threshold;
-    bool threshold_event;
-} data;
+    bool previous;
+    int  consistency;
+};
+
+// frames seen by the temporal filter, for one target matrix
+struct temporal_state {
+    // exponential moving average, in 1/256 mm (negative if invalid)
+    int32_t average[64];
+
+    // ring buffer of the last frames
+    int16_t history[TOF2CAN_TEMPORAL_MAX_LENGTH][64];
+    int history_index;
+    int history_count;
+};
+
+// Processing state of each sensor
+static struct sensor {
+    int  index;
+    bool ranging;
+
+    // Ping-pong buffers: the acquiring side writes into
+    // frames[write_index], while the transmitting side reads from the
+    // other one.
+    struct processing_frame frames[2];
+    struct processing_frame *frame;
+
+    struct {
+        int  write_index;
+        bool ready;   // the read buffer contains data not yet acquired
+        bool reading; // the read buffer is being used by the transmitter
+        bool pending; // the write buffer contains data waiting to be swapped
+
+        // threshold events of frames replaced before being acquired, to
+        // be reported by the next frame (bit N is set for channel N)
+        int lost_events;
+
+        pthread_mutex_t lock;
+    } handover;
+
+    struct channel channels[PROCESSING_CHANNEL_COUNT];
+
+    // zones not passing the filter are invalid
+    struct {
+        uint16_t accepted_statuses; // bit N is set if status N is valid
+        int max_sigma;              // 0 = no limit
+        int min_signal;             // 0 = no limit
+    } filter;
+
+    // targets processed in each zone
+    struct {
+        int policy;
+        int secondary_channels; // bit N is set if channel N uses them
+    } targets;
+
+    // temporal filter, applied to each zone over consecutive frames
+    struct {
+        int mode;
+        int weight; // EMA weight of the newest sample, out of 256
+        int length; // number of frames of the median
+
+        // past frames of the primary and secondary target matrices
+        struct temporal_state primary;
+        struct temporal_state secondary;
+    } temporal;
+} sensors[TOF_MAX_SENSORS];
+
+uint32_t processing_frames_acquired[TOF_MAX_SENSORS];
+
+// matrices of the primary and secondary target of each zone, filtered
+static int16_t primary_matrix[64];
+static int16_t secondary_matrix[64];
+
+// quantities gathered from the area of a channel
+struct matrix_stats {
+    int count, sum, min, max;
+
+    // valid samples, only collected for percentile selectors
+    int16_t samples[PROCESSING_DATA_MAX_LENGTH];
+};
+
+static inline bool needs_samples(const struct channel *channel) {
+    return channel->result_selector == SELECTOR_MEDIAN ||
+           channel->result_selector == SELECTOR_PERCENTILE;
+}
+
+static void dump_data(const struct sensor *s, int channel_index,
+                      const int16_t *matrix) {
+    const struct channel *channel = &s->channels[channel_index];
+    const struct processing_data *data = &s->frame->channels[channel_index];
 
-static struct {
-    int x0, y0, x1, y1;
-} bounds;
-static int result_selector;
+    const int width = tof_get_matrix_width(s->index);
 
-static int threshold;
-static int threshold_delay;
-static int threshold_focus;
+    LOG(LOG_EVENT_DUMP_BEGIN, s->index, channel_index);
 
-static void dump_data(int16_t *matrix) {
-    printf("=== DATA DUMP ===\n");
+    // rows are at most 8 zones wide, one entry each
+    for(int y = channel->bounds.y0; y <= channel->bounds.y1; y++) {
+        const int x0 = channel->bounds.x0;
+        log_write(
+            LOG_EVENT_DUMP_ROW, &matrix[x0 + y * width],
+            channel->bounds.x1 - x0 + 1
+        );
+    }
+
+    for(int i = 0; i < data->buffer_length; i += LOG_MAX_ARGS) {
+        int count = data->buffer_length - i;
+        if(count > LOG_MAX_ARGS)
+            count = LOG_MAX_ARGS;
+        log_write(LOG_EVENT_DUMP_DATA, &data->buffer[i], count);
+    }
+
+    LOG(
+        LOG_EVENT_DUMP_THRESHOLD,
+        data->below_threshold, data->threshold_event
+    );
+}
 
-    for(int y = bounds.y0; y <= bounds.y1; y++) {
-        for(int x = bounds.x0; x <= bounds.x1; x++) {
-            const int index = x + y * tof_matrix_width;
-            printf("%d, ", matrix[index]);
+static inline bool is_target_valid(const struct sensor *s,
+                                   const struct tof_data *tof_data,
+                                   int index) {
+    const int status = tof_data->status[index];
+
+    bool valid = (
+        status < 16 && (s->filter.accepted_statuses & (1 << status)) &&
+        tof_data->distance[index] >= 0
+    );
+    if(s->filter.max_sigma != 0 &&
+       tof_data->sigma[index] > s->filter.max_sigma)
+        valid = false;
+    if(s->filter.min_signal != 0 &&
+       tof_data->signal_per_spad[index] < (uint32_t) s->filter.min_signal)
+        valid = false;
+    return valid;
+}
+
+// Returns true if target 'a' is preferred to target 'b'
+static inline bool is_target_preferred(const struct sensor *s,
+                                       const struct tof_data *tof_data,
+                                       int a, int b) {
+    switch(s->targets.policy) {
+        case TOF2CAN_TARGET_STRONGEST:
+            return tof_data->signal_per_spad[a] >
+                   tof_data->signal_per_spad[b];
+
+        case TOF2CAN_TARGET_FARTHEST:
+            return tof_data->distance[a] > tof_data->distance[b];
+
+        default:
+            return tof_data->distance[a] < tof_data->distance[b];
+    }
+}
+
+// Reads the targets of each zone in place, through the strided view,
+// and writes the distance of the primary and (if requested) secondary
+// target into the matrices. Zones without such a target are invalid.
+static void filter_matrix(const struct sensor *s,
+                          const struct tof_data *tof_data,
+                          bool secondary) {
+    const int width = tof_get_matrix_width(s->index);
+    const int zones = width * width;
+
+    for(int z = 0; z < zones; z++) {
+        const int first = z * tof_data->stride;
+        int count = tof_data->nb_targets[z];
+        if(count > tof_data->stride)
+            count = tof_data->stride;
+
+        // indices of the best and second best valid targets
+        int best = -1, second = -1;
+        for(int i = first; i < first + count; i++) {
+            if(!is_target_valid(s, tof_data, i))
+                continue;
+
+            if(best < 0 || is_target_preferred(s, tof_data, i, best)) {
+                second = best;
+                best = i;
+            } else if(second < 0 ||
+                      is_target_preferred(s, tof_data, i, second)) {
+                second = i;
+            }
         }
-        printf("\n");
+
+        primary_matrix[z] = (best < 0 ? -1 : tof_data->distance[best]);
+        if(secondary) {
+            secondary_matrix[z] = (
+                second < 0 ? -1 : tof_data->distance[second]
+            );
+        }
+    }
+}
+
+static inline const int16_t *get_matrix(const struct sensor *s,
+                                        int channel) {
+    if(s->targets.secondary_channels & (1 << channel))
+        return secondary_matrix;
+    return primary_matrix;
+}
+
+static void temporal_average(const struct sensor *s,
+                             struct temporal_state *state,
+                             int16_t *matrix, int zones) {
+    for(int i = 0; i < zones; i++) {
+        const int32_t sample = matrix[i];
+        int32_t *average = &state->average[i];
+
+        // invalid zones restart the average
+        if(sample < 0) {
+            *average = -1;
+            continue;
+        }
+
+        if(*average < 0)
+            *average = sample * 256;
+        else
+            *average += (
+                (sample * 256 - *average) * s->temporal.weight / 256
+            );
+
+        matrix[i] = (*average + 128) / 256;
+    }
+}
+
+static void temporal_median(const struct sensor *s,
+                            struct temporal_state *state,
+                            int16_t *matrix, int zones) {
+    // store the current frame in the ring buffer
+    memcpy(
+        state->history[state->history_index], matrix,
+        zones * sizeof(int16_t)
+    );
+    state->history_index = (state->history_index + 1) % s->temporal.length;
+    if(state->history_count < s->temporal.length)
+        state->history_count++;
+
+    for(int i = 0; i < zones; i++) {
+        int16_t samples[TOF2CAN_TEMPORAL_MAX_LENGTH];
+        int count = 0;
+
+        // insertion sort of the valid samples of the zone
+        for(int f = 0; f < state->history_count; f++) {
+            const int16_t sample = state->history[f][i];
+            if(sample < 0)
+                continue;
+
+            int j = count++;
+            for(; j > 0 && samples[j - 1] > sample; j--)
+                samples[j] = samples[j - 1];
+            samples[j] = sample;
+        }
+
+        // the zone is valid if most of the frames are valid
+        if(count * 2 > state->history_count)
+            matrix[i] = samples[(count - 1) / 2];
+        else
+            matrix[i] = -1;
     }
-    printf("\n");
+}
+
+static void temporal_filter(const struct sensor *s,
+                            struct temporal_state *state,
+                            int16_t *matrix) {
+    const int width = tof_get_matrix_width(s->index);
+    const int zones = width * width;
 
-    printf("Distance data: ");
-    for(int i = 0; i < data.buffer_length; i++)
-        printf("%d, ", data.buffer[i]);
-    printf("\n");
+    switch(s->temporal.mode) {
+        case TOF2CAN_TEMPORAL_AVERAGE:
+            temporal_average(s, state, matrix, zones);
+            break;
 
-    printf("Below threshold: %d\n", data.below_threshold);
-    printf("Threshold event: %d\n", data.threshold_event);
-    printf("\n");
+        case TOF2CAN_TEMPORAL_MEDIAN:
+            temporal_median(s, state, matrix, zones);
+            break;
+    }
 }
 
-static int process_matrix(int16_t *matrix, uint8_t *status,
-                          int *count, int *sum, int *min, int *max) {
-    *count = 0;
-    *sum   = 0;
-    *min   = INT_MAX;
-    *max   = INT_MIN;
+// Forgets the frames seen by the temporal filter
+static void temporal_reset(struct temporal_state *state) {
+    for(int i = 0; i < 64; i++)
+        state->average[i] = -1;
+    state->history_index = 0;
+    state->history_count = 0;
+}
+
+static int process_matrix(const struct channel *channel,
+                          const int16_t *matrix, int width,
+                          struct matrix_stats *stats) {
+    stats->count = 0;
+    stats->sum   = 0;
+    stats->min   = INT_MAX;
+    stats->max   = INT_MIN;
+
+    const bool collect = needs_samples(channel);
 
     // look for data within the configured bounds
-    for(int y = bounds.y0; y <= bounds.y1; y++) {
-        for(int x = bounds.x0; x <= bounds.x1; x++) {
-            const int index = x + y * tof_matrix_width;
+    for(int y = channel->bounds.y0; y <= channel->bounds.y1; y++) {
+        for(int x = channel->bounds.x0; x <= channel->bounds.x1; x++) {
+            const int index = x + y * width;
             const int sample = matrix[index];
 
-            // check if point is valid
-            if(status[index] != 5 && status[index] != 9) {
-                matrix[index] = -1;
+            // skip invalid points
+            if(sample < 0)
                 continue;
-            }
 
-            *count += 1;
-            *sum   += sample;
+            if(collect)
+                stats->samples[stats->count] = sample;
 
-            if(*min > sample)
-                *min = sample;
+            stats->count += 1;
+            stats->sum   += sample;
 
-            if(*max < sample)
-                *max = sample;
+            if(stats->min > sample)
+                stats->min = sample;
+
+            if(stats->max < sample)
+                stats->max = sample;
         }
     }
 
     // if no valid samples were found, return an error
-    return (*count == 0);
+    return (stats->count == 0);
 }
 
-static void update_threshold_status(int focus) {
-    static bool previous    = false;
-    static int  consistency = 0;
-
-    const bool current = (focus < threshold);
-    if(current == previous)
-        consistency++;
+static void update_threshold_status(struct channel *channel,
+                                    struct processing_data *data,
+                                    int focus) {
+    const bool current = (focus < channel->threshold);
+    if(current == channel->previous)
+        channel->consistency++;
     else
-        consistency = 0;
-    previous = current;
+        channel->consistency = 0;
+    channel->previous = current;
 
-    const bool consistent_enough = (consistency >= threshold_delay);
-    const bool status_change = (data.below_threshold != current);
+    const bool consistent_enough = (
+        channel->consistency >= channel->threshold_delay
+    );
+    const bool status_change = (channel->below_threshold != current);
 
     // if readings are consistent enough, update status and event flag
     if(consistent_enough && status_change) {
-        data.below_threshold = current;
-        data.threshold_event = true;
+        channel->below_threshold = current;
+        data->threshold_event = true;
     } else {
-        data.threshold_event = false;
+        data->threshold_event = false;
     }
+    data->below_threshold = channel->below_threshold;
 }
 
-static int update_data(void) {
-    int16_t *matrix;
-    uint8_t *status;
+// Records the threshold events of a frame that will never be acquired
+static void keep_events(struct sensor *s,
+                        const struct processing_frame *frame) {
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++)
+        if(frame->channels[i].available &&
+           frame->channels[i].threshold_event)
+            s->handover.lost_events |= (1 << i);
+}
 
-    // read ToF data, if available
-    if(tof_read_data(&matrix, &status))
-        return 1;
+// Reports the recorded events in the frame just written, if possible
+static void restore_events(struct sensor *s) {
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++) {
+        struct processing_data *data = &s->frame->channels[i];
+        if(!data->available || !(s->handover.lost_events & (1 << i)))
+            continue;
 
-    // process the matrix to gather data about its elements
-    int count, sum, min, max;
-    if(process_matrix(matrix, status, &count, &sum, &min, &max)) {
-        printf("[Processing] no valid data point was found\n");
-        return 1;
+        data->threshold_event = true;
+        s->handover.lost_events &= ~(1 << i);
     }
+}
+
+static void begin_write(struct sensor *s) {
+    pthread_mutex_lock(&s->handover.lock);
+
+    // the write buffer is about to be overwritten
+    if(s->handover.pending)
+        keep_events(s, &s->frames[s->handover.write_index]);
+    s->handover.pending = false;
+    s->frame = &s->frames[s->handover.write_index];
+
+    pthread_mutex_unlock(&s->handover.lock);
+}
+
+static inline void swap_buffers(struct sensor *s) {
+    s->handover.write_index ^= 1;
+    s->handover.ready   = true;
+    s->handover.pending = false;
+}
+
+static void end_write(struct sensor *s) {
+    pthread_mutex_lock(&s->handover.lock);
+
+    // a frame not yet acquired is about to be replaced
+    if(s->handover.ready && !s->handover.reading)
+        keep_events(s, &s->frames[s->handover.write_index ^ 1]);
+    restore_events(s);
+
+    // if the read buffer is in use, swap when it is released
+    if(s->handover.reading)
+        s->handover.pending = true;
+    else
+        swap_buffers(s);
+
+    pthread_mutex_unlock(&s->handover.lock);
+}
+
+static void update_channel(struct channel *channel,
+                           struct processing_data *data,
+                           const int16_t *matrix, int width,
+                           const struct matrix_stats *stats) {
+    data->buffer_length = channel->data_length;
 
     // update data based on result selector
-    switch(result_selector) {
+    switch(channel->result_selector) {
         case SELECTOR_MIN: {
-            data.buffer[0] = min;
+            data->buffer[0] = stats->min;
         } break;
 
         case SELECTOR_MAX: {
-            data.buffer[0] = max;
+            data->buffer[0] = stats->max;
         } break;
 
         case SELECTOR_AVERAGE: {
-            data.buffer[0] = (sum / count);
+            data->buffer[0] = (stats->sum / stats->count);
+        } break;
+
+        case SELECTOR_MEDIAN: {
+            data->buffer[0] = selection_percentile(
+                stats->samples, stats->count, 50
+            );
+        } break;
+
+        case SELECTOR_PERCENTILE: {
+            data->buffer[0] = selection_percentile(
+                stats->samples, stats->count, channel->percentile
+            );
         } break;
 
         case SELECTOR_ALL: {
             // copy all data points within the configured bounds
             int i = 0;
-            for(int y = bounds.y0; y <= bounds.y1; y++) {
-                for(int x = bounds.x0; x <= bounds.x1; x++) {
-                    const int index = x + y * tof_matrix_width;
-                    data.buffer[i++] = matrix[index];
+            for(int y = channel->bounds.y0; y <= channel->bounds.y1; y++) {
+                for(int x = channel->bounds.x0; x <= channel->bounds.x1; x++) {
+                    const int index = x + y * width;
+                    data->buffer[i++] = matrix[index];
                 }
             }
         } break;
@@ -176,160 +508,468 @@ static int update_data(void) {
 
     // update threshold status
     int focus = 0;
-    switch(threshold_focus) {
+    switch(channel->threshold_focus) {
         case TOF2CAN_THRESHOLD_FOCUS_MIN:
-            focus = min;
+            focus = stats->min;
             break;
 
         case TOF2CAN_THRESHOLD_FOCUS_MAX:
-            focus = max;
+            focus = stats->max;
             break;
 
         case TOF2CAN_THRESHOLD_FOCUS_AVERAGE:
-            focus = (sum / count);
+            focus = (stats->sum / stats->count);
             break;
 
         case TOF2CAN_THRESHOLD_FOCUS_SUM:
-            focus = sum;
+            focus = stats->sum;
             break;
     }
-    update_threshold_status(focus);
 
-    // dump ToF matrix and processed data
-    if(debug_flag)
-        dump_data(matrix);
+    const uint32_t start = timing_profile_begin();
+    update_threshold_status(channel, data, focus);
+    timing_profile_end(TIMING_PROFILE_THRESHOLD, start);
+}
+
+static int update_data(struct sensor *s) {
+    struct tof_data tof_data;
+
+    // read ToF data, if available
+    const uint32_t start = timing_profile_begin();
+    if(tof_read_data(s->index, &tof_data))
+        return 1;
+    timing_profile_end(TIMING_PROFILE_READ, start);
+    processing_frames_acquired[s->index]++;
+
+    // select the target of each zone, marking zones without a target
+    // passing the filter as invalid (-1)
+    bool secondary = false;
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++)
+        if(s->channels[i].enabled &&
+           (s->targets.secondary_channels & (1 << i)))
+            secondary = true;
+    filter_matrix(s, &tof_data, secondary);
+
+    // smooth each zone over time, following each target separately
+    temporal_filter(s, &s->temporal.primary, primary_matrix);
+    if(secondary)
+        temporal_filter(s, &s->temporal.secondary, secondary_matrix);
+
+    // process the matrix to gather data about the area of each channel
+    const int width = tof_get_matrix_width(s->index);
+    struct matrix_stats stats[PROCESSING_CHANNEL_COUNT];
+    bool available[PROCESSING_CHANNEL_COUNT];
+    int available_count = 0;
+
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++) {
+        if(!s->channels[i].enabled) {
+            available[i] = false;
+            continue;
+        }
+
+        const uint32_t start = timing_profile_begin();
+        available[i] = !process_matrix(
+            &s->channels[i], get_matrix(s, i), width, &stats[i]
+        );
+        timing_profile_end(TIMING_PROFILE_PROCESS, start);
+        available_count += available[i];
+    }
+
+    if(available_count == 0) {
+        LOG(LOG_EVENT_NO_VALID_DATA, s->index);
+        return 1;
+    }
+
+    begin_write(s);
+    s->frame->captured = tof_data.captured;
+    for(int i = 0; i < PROCESSING_CHANNEL_COUNT; i++) {
+        struct processing_data *data = &s->frame->channels[i];
+
+        data->available = available[i];
+        if(!data->available)
+            continue;
 
+        update_channel(
+            &s->channels[i], data, get_matrix(s, i), width, &stats[i]
+        );
+
+        // dump ToF matrix and processed data
+        if(log_enabled(LOG_LEVEL_DEBUG))
+            dump_data(s, i, get_matrix(s, i));
+    }
+    end_write(s);
     return 0;
 }
 
-void processing_run(void) {
-    if(!update_data())
-        data.available = true;
+static inline bool is_sensor_valid(int sensor) {
+    return (sensor >= 0 && sensor < tof_sensor_count);
+}
+
+void processing_init(void) {
+    for(int i = 0; i < TOF_MAX_SENSORS; i++) {
+        struct sensor *s = &sensors[i];
+
+        s->index = i;
+        s->frame = &s->frames[0];
+        pthread_mutex_init(&s->handover.lock, NULL);
+
+        s->channels[0].enabled      = true;
+        s->filter.accepted_statuses = TOF2CAN_FILTER_DEFAULT_STATUSES;
+    }
+}
+
+int processing_run(int sensor) {
+    timing_begin(TIMING_STAGE_ACQUIRE);
+    const int err = update_data(&sensors[sensor]);
+    timing_end(TIMING_STAGE_ACQUIRE, !err);
+    return err;
 }
 
-void processing_pause(void) {
-    tof_stop_ranging();
-    data.available = false; // invalidate data
+void processing_pause(int sensor) {
+    struct sensor *s = &sensors[sensor];
+
+    tof_stop_ranging(sensor);
+    s->ranging = false;
+
+    // invalidate data
+    pthread_mutex_lock(&s->handover.lock);
+    s->handover.ready       = false;
+    s->handover.pending     = false;
+    s->handover.lost_events = 0;
+    pthread_mutex_unlock(&s->handover.lock);
 }
 
-void processing_resume(void) {
-    tof_start_ranging();
+void processing_resume(int sensor) {
+    tof_start_ranging(sensor);
+    sensors[sensor].ranging = true;
 }
 
-int processing_get_data(int16_t *buffer,
-                        int *length,
-                        bool *below_threshold,
-                        bool *threshold_event) {
+// Reads only the sensor outputs needed by the filter. Changing them
+// requires restarting ranging.
+static void update_outputs(const struct sensor *s) {
+    int outputs = 0;
+    if(s->filter.max_sigma != 0)
+        outputs |= TOF_OUTPUT_SIGMA;
+    if(s->filter.min_signal != 0 ||
+       s->targets.policy == TOF2CAN_TARGET_STRONGEST)
+        outputs |= TOF_OUTPUT_SIGNAL;
+
+    if(outputs == tof_get_outputs(s->index))
+        return;
+
+    const bool restart = s->ranging;
+    if(restart)
+        processing_pause(s->index);
+
+    tof_set_outputs(s->index, outputs);
+
+    if(restart)
+        processing_resume(s->index);
+}
+
+const struct processing_frame *processing_acquire_data(int sensor) {
+    struct sensor *s = &sensors[sensor];
+    const struct processing_frame *result = NULL;
+    pthread_mutex_lock(&s->handover.lock);
+
     // check if data is available
-    if(!data.available)
-        return 1;
+    if(s->handover.ready) {
+        s->handover.ready   = false;
+        s->handover.reading = true;
+        result = &s->frames[s->handover.write_index ^ 1];
+    }
+
+    pthread_mutex_unlock(&s->handover.lock);
+    return result;
+}
 
-    // copy data to the given pointers
-    memcpy(buffer, data.buffer, data.buffer_length * sizeof(int16_t));
-    *length          = data.buffer_length;
-    *below_threshold = data.below_threshold;
-    *threshold_event = data.threshold_event;
+void processing_release_data(int sensor) {
+    struct sensor *s = &sensors[sensor];
+    pthread_mutex_lock(&s->handover.lock);
+    s->handover.reading = false;
 
-    data.available = false;
-    return 0;
+    // if a newer frame was completed in the meantime, publish it
+    if(s->handover.pending)
+        swap_buffers(s);
+
+    pthread_mutex_unlock(&s->handover.lock);
 }
 
-int processing_set_mode(int mode) {
+static inline bool is_channel_valid(int channel) {
+    return (channel >= 0 && channel < PROCESSING_CHANNEL_COUNT);
+}
+
+static void set_area(struct sensor *s, int index,
+                     int x0, int y0, int x1, int y1, int selector) {
+    struct channel *channel = &s->channels[index];
+
+    channel->bounds.x0 = x0;
+    channel->bounds.y0 = y0;
+    channel->bounds.x1 = x1;
+    channel->bounds.y1 = y1;
+    channel->result_selector = selector;
+
+    // set data length
+    if(channel->result_selector == SELECTOR_ALL) {
+        const int width  = (x1 - x0 + 1);
+        const int height = (y1 - y0 + 1);
+        channel->data_length = width * height;
+    } else {
+        channel->data_length = 1;
+    }
+
+    printf(
+        "[Processing] setting area of sensor %d channel %d to "
+        "(%d, %d, %d, %d), result selector to %d, data length to %d\n",
+        s->index, index, x0, y0, x1, y1,
+        channel->result_selector, channel->data_length
+    );
+}
+
+int processing_set_enabled(int sensor, int channel, bool enabled) {
+    int err = 0;
+
+    if(is_sensor_valid(sensor) && is_channel_valid(channel)) {
+        struct channel *c = &sensors[sensor].channels[channel];
+        c->enabled = enabled;
+
+        // start again from the default threshold status
+        c->below_threshold = false;
+        c->previous        = false;
+        c->consistency     = 0;
+    } else {
+        err = 1;
+    }
+
+    printf(
+        "[Processing] setting sensor %d channel %d enabled to %d "
+        "(err=%d)\n",
+        sensor, channel, enabled, err
+    );
+    return err;
+}
+
+int processing_set_mode(int sensor, int channel, int mode) {
+    if(!is_sensor_valid(sensor) || !is_channel_valid(channel)) {
+        printf(
+            "[Processing] invalid sensor %d or channel %d\n",
+            sensor, channel
+        );
+        return 1;
+    }
+
+    struct sensor *s = &sensors[sensor];
     const int area = (mode >> 6) & 3;
+    const int last = tof_get_matrix_width(sensor) - 1;
 
     // set bounds of area to process and result selector
     switch(area) {
         case AREA_MATRIX: {
             const int selector = (mode >> 4) & 3;
 
-            bounds.x0 = bounds.y0 = 0;
-            bounds.x1 = bounds.y1 = tof_matrix_width - 1;
-            result_selector = selector;
+            set_area(s, channel, 0, 0, last, last, selector);
         } break;
 
         case AREA_COLUMN: {
             const int column = (mode & 7);
             const int selector = (mode >> 4) & 3;
 
-            bounds.x0 = bounds.x1 = column;
-            bounds.y0 = 0;
-            bounds.y1 = tof_matrix_width - 1;
-            result_selector = selector;
+            set_area(s, channel, column, 0, column, last, selector);
         } break;
 
         case AREA_ROW: {
             const int row = (mode & 7);
             const int selector = (mode >> 4) & 3;
 
-            bounds.x0 = 0;
-            bounds.x1 = tof_matrix_width - 1;
-            bounds.y0 = bounds.y1 = row;
-            result_selector = selector;
+            set_area(s, channel, 0, row, last, row, selector);
         } break;
 
         case AREA_POINT: {
             const int x = (mode & 7);
             const int y = (mode >> 3) & 7;
 
-            bounds.x0 = bounds.x1 = x;
-            bounds.y0 = bounds.y1 = y;
-            result_selector = SELECTOR_MIN;
+            set_area(s, channel, x, y, x, y, SELECTOR_MIN);
         } break;
     }
+    return 0;
+}
 
-    // set data length
-    if(result_selector == SELECTOR_ALL) {
-        const int width  = (bounds.x1 - bounds.x0 + 1);
-        const int height = (bounds.y1 - bounds.y0 + 1);
-        data.buffer_length = width * height;
+int processing_set_area(int sensor, int channel,
+                        int x0, int y0, int x1, int y1, int selector) {
+    const bool valid = (
+        is_sensor_valid(sensor) && is_channel_valid(channel) &&
+        x0 >= 0 && x0 <= x1 && x1 < tof_get_matrix_width(sensor) &&
+        y0 >= 0 && y0 <= y1 && y1 < tof_get_matrix_width(sensor) &&
+        selector >= 0 && selector <= SELECTOR_PERCENTILE
+    );
+
+    if(!valid) {
+        printf(
+            "[Processing] invalid area (%d, %d, %d, %d) "
+            "or result selector %d for sensor %d channel %d\n",
+            x0, y0, x1, y1, selector, sensor, channel
+        );
+        return 1;
+    }
+
+    set_area(&sensors[sensor], channel, x0, y0, x1, y1, selector);
+    return 0;
+}
+
+int processing_set_selector(int sensor, int channel, int selector,
+                            int percentile) {
+    const bool valid = (
+        is_sensor_valid(sensor) && is_channel_valid(channel) &&
+        selector >= 0 && selector <= SELECTOR_PERCENTILE &&
+        percentile >= 0 && percentile <= 100
+    );
+
+    if(!valid) {
+        printf(
+            "[Processing] invalid result selector %d or percentile %d "
+            "for sensor %d channel %d\n",
+            selector, percentile, sensor, channel
+        );
+        return 1;
+    }
+
+    struct sensor *s = &sensors[sensor];
+    struct channel *c = &s->channels[channel];
+    c->percentile = percentile;
+
+    // keep the current area
+    set_area(
+        s, channel, c->bounds.x0, c->bounds.y0, c->bounds.x1, c->bounds.y1,
+        selector
+    );
+    return 0;
+}
+
+int processing_set_filter(int sensor, int accepted_statuses,
+                          int max_sigma, int min_signal) {
+    int err = 0;
+
+    if(is_sensor_valid(sensor) && max_sigma >= 0 && min_signal >= 0) {
+        struct sensor *s = &sensors[sensor];
+        s->filter.accepted_statuses = accepted_statuses;
+        s->filter.max_sigma         = max_sigma;
+        s->filter.min_signal        = min_signal;
+        update_outputs(s);
     } else {
-        data.buffer_length = 1;
+        err = 1;
     }
 
     printf(
-        "[Processing] setting area to (%d, %d, %d, %d), "
-        "result selector to %d, data length to %d\n",
-        bounds.x0, bounds.y0, bounds.x1, bounds.y1,
-        result_selector, data.buffer_length
+        "[Processing] setting filter of sensor %d to statuses 0x%04x, "
+        "max sigma %d, min signal %d (err=%d)\n",
+        sensor, accepted_statuses, max_sigma, min_signal, err
     );
-    return 0;
+    return err;
+}
+
+int processing_set_targets(int sensor, int policy,
+                           int secondary_channels) {
+    int err = 0;
+
+    if(is_sensor_valid(sensor) && policy >= 0 && policy < 3 &&
+       secondary_channels >= 0 &&
+       secondary_channels < (1 << PROCESSING_CHANNEL_COUNT)) {
+        struct sensor *s = &sensors[sensor];
+        s->targets.policy             = policy;
+        s->targets.secondary_channels = secondary_channels;
+        update_outputs(s);
+
+        // the secondary target was not followed while no channel used it
+        temporal_reset(&s->temporal.secondary);
+    } else {
+        err = 1;
+    }
+
+    printf(
+        "[Processing] setting target policy of sensor %d to %d, "
+        "secondary target channels 0x%x (err=%d)\n",
+        sensor, policy, secondary_channels, err
+    );
+    return err;
+}
+
+int processing_set_temporal_filter(int sensor, int mode, int weight,
+                                   int length) {
+    int err = 0;
+
+    const bool valid = is_sensor_valid(sensor) && (
+        (mode == TOF2CAN_TEMPORAL_NONE) ||
+        (mode == TOF2CAN_TEMPORAL_AVERAGE && weight >= 1 && weight <= 255) ||
+        (mode == TOF2CAN_TEMPORAL_MEDIAN &&
+         length >= 1 && length <= TOF2CAN_TEMPORAL_MAX_LENGTH)
+    );
+
+    if(valid) {
+        struct sensor *s = &sensors[sensor];
+        s->temporal.mode   = mode;
+        s->temporal.weight = weight;
+        s->temporal.length = length;
+
+        // forget previous frames
+        temporal_reset(&s->temporal.primary);
+        temporal_reset(&s->temporal.secondary);
+    } else {
+        err = 1;
+    }
+
+    printf(
+        "[Processing] setting temporal filter of sensor %d to %d "
+        "(weight=%d, length=%d, err=%d)\n",
+        sensor, mode, weight, length, err
+    );
+    return err;
 }
 
-int processing_set_threshold(int _threshold) {
+int processing_set_threshold(int sensor, int channel, int threshold) {
     int err = 0;
 
-    if(_threshold >= 0) threshold = _threshold;
-    else err = 1;
+    if(is_sensor_valid(sensor) && is_channel_valid(channel) &&
+       threshold >= 0)
+        sensors[sensor].channels[channel].threshold = threshold;
+    else
+        err = 1;
 
     printf(
-        "[Processing] setting threshold to %d (err=%d)\n",
-        _threshold, err
+        "[Processing] setting threshold of sensor %d channel %d to %d "
+        "(err=%d)\n",
+        sensor, channel, threshold, err
     );
     return err;
 }
 
-int processing_set_threshold_delay(int delay) {
+int processing_set_threshold_delay(int sensor, int channel, int delay) {
     int err = 0;
 
-    if(delay >= 0) threshold_delay = delay;
-    else err = 1;
+    if(is_sensor_valid(sensor) && is_channel_valid(channel) && delay >= 0)
+        sensors[sensor].channels[channel].threshold_delay = delay;
+    else
+        err = 1;
 
     printf(
-        "[Processing] setting threshold delay to %d (err=%d)\n",
-        delay, err
+        "[Processing] setting threshold delay of sensor %d channel %d "
+        "to %d (err=%d)\n",
+        sensor, channel, delay, err
     );
     return err;
 }
 
-int processing_set_threshold_focus(int focus) {
+int processing_set_threshold_focus(int sensor, int channel, int focus) {
     int err = 0;
 
-    if(focus >= 0) threshold_focus = focus;
-    else err = 1;
+    if(is_sensor_valid(sensor) && is_channel_valid(channel) && focus >= 0)
+        sensors[sensor].channels[channel].threshold_focus = focus;
+    else
+        err = 1;
 
     printf(
-        "[Processing] setting threshold focus to %d (err=%d)\n",
-        focus, err
+        "[Processing] setting threshold focus of sensor %d channel %d "
+        "to %d (err=%d)\n",
+        sensor, channel, focus, err
     );
     return err;
 }
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "selection.h"
+
+#include <string.h>
+
+// Radix selection: the upper 6 bits of the k-th sample are found from a
+// histogram of all samples, then the lower 6 bits from a histogram of
+// the samples sharing the same upper bits.
+#define DIGIT_BITS  6
+#define DIGIT_COUNT (1 << DIGIT_BITS)
+#define DIGIT_MASK  (DIGIT_COUNT - 1)
+
+static inline int saturate(int sample) {
+    if(sample < 0)
+        return 0;
+    if(sample > SELECTION_MAX_VALUE)
+        return SELECTION_MAX_VALUE;
+    return sample;
+}
+
+int selection_kth(const int16_t *samples, int count, int k) {
+    uint8_t histogram[DIGIT_COUNT];
+
+    // find the upper digit
+    memset(histogram, 0, sizeof(histogram));
+    for(int i = 0; i < count; i++)
+        histogram[saturate(samples[i]) >> DIGIT_BITS]++;
+
+    int upper = 0;
+    while(k >= histogram[upper]) {
+        k -= histogram[upper];
+        upper++;
+    }
+
+    // find the lower digit, among samples having the same upper digit
+    memset(histogram, 0, sizeof(histogram));
+    for(int i = 0; i < count; i++) {
+        const int sample = saturate(samples[i]);
+        if((sample >> DIGIT_BITS) == upper)
+            histogram[sample & DIGIT_MASK]++;
+    }
+
+    int lower = 0;
+    while(k >= histogram[lower]) {
+        k -= histogram[lower];
+        lower++;
+    }
+
+    return (upper << DIGIT_BITS) | lower;
+}
+
+int selection_percentile(const int16_t *samples, int count,
+                         int percentile) {
+    // nearest rank: ceil(percentile * count / 100), starting from 1
+    int k = (percentile * count + 99) / 100 - 1;
+    if(k < 0)
+        k = 0;
+
+    return selection_kth(samples, count, k);
+}
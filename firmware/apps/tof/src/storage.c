@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "storage.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <nuttx/crc32.h>
+#include <nuttx/progmem.h>
+
+#define STORAGE_MAGIC 0x524f5453 // "STOR"
+
+// Records start with this header. The flash is written in 8-byte units.
+struct record_header {
+    uint32_t magic;
+    uint16_t key;
+    uint16_t size;
+    uint32_t checksum; // CRC-32 of the data
+    uint32_t _padding;
+};
+
+#define WRITE_UNIT 8
+
+static ssize_t get_page(int key) {
+    if(key < 0 || key >= STORAGE_KEY_COUNT)
+        return -1;
+    return up_progmem_neraseblocks() - 1 - key;
+}
+
+int storage_read(int key, void *data, int size) {
+    const ssize_t page = get_page(key);
+    if(page < 0)
+        return 1;
+
+    const uint8_t *address = (const uint8_t *) up_progmem_getaddress(page);
+
+    struct record_header header;
+    memcpy(&header, address, sizeof(header));
+
+    if(header.magic != STORAGE_MAGIC || header.key != key ||
+       header.size != size)
+        return 1;
+
+    const uint8_t *record_data = &address[sizeof(header)];
+    if(crc32(record_data, size) != header.checksum)
+        return 1;
+
+    memcpy(data, record_data, size);
+    return 0;
+}
+
+static int write_record(ssize_t page, int key, const uint8_t *data,
+                        int size) {
+    if(size <= 0 ||
+       sizeof(struct record_header) + size > up_progmem_pagesize(page))
+        return 1;
+
+    if(up_progmem_eraseblock(page) < 0)
+        return 1;
+
+    const size_t address = up_progmem_getaddress(page);
+    const size_t data_address = address + sizeof(struct record_header);
+
+    // write the data first, so that the record only becomes valid once
+    // the header is written
+    const int aligned_size = size - (size % WRITE_UNIT);
+    if(aligned_size > 0 &&
+       up_progmem_write(data_address, data, aligned_size) < 0)
+        return 1;
+
+    if(aligned_size < size) {
+        uint8_t tail[WRITE_UNIT];
+        memset(tail, 0xff, sizeof(tail));
+        memcpy(tail, &data[aligned_size], size - aligned_size);
+
+        if(up_progmem_write(data_address + aligned_size,
+                            tail, sizeof(tail)) < 0)
+            return 1;
+    }
+
+    const struct record_header header = {
+        .magic    = STORAGE_MAGIC,
+        .key      = key,
+        .size     = size,
+        .checksum = crc32(data, size)
+    };
+    if(up_progmem_write(address, &header, sizeof(header)) < 0)
+        return 1;
+    return 0;
+}
+
+int storage_write(int key, const void *data, int size) {
+    const ssize_t page = get_page(key);
+
+    int err = 1;
+    if(page >= 0)
+        err = write_record(page, key, data, size);
+
+    printf(
+        "[Storage] writing record %d, %d bytes (err=%d)\n",
+        key, size, err
+    );
+    return err;
+}
+
+int storage_erase(int key) {
+    const ssize_t page = get_page(key);
+
+    int err = 1;
+    if(page >= 0)
+        err = (up_progmem_eraseblock(page) < 0);
+
+    printf("[Storage] erasing record %d (err=%d)\n", key, err);
+    return err;
+}
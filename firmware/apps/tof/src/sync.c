@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "sync.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <nuttx/arch.h>
+
+// bus time is reported as not synced without sync messages for this long
+#define SYNC_TIMEOUT_MS 10000
+
+// the rate is measured over intervals of this length
+#define RATE_MIN_INTERVAL_MS 500
+#define RATE_MAX_INTERVAL_MS 20000
+
+// each measured rate moves the rate by this fraction of the difference
+#define RATE_SMOOTHING 16
+
+// measured rates further than this from the nominal one are ignored
+#define RATE_MAX_DRIFT_PPM 20000
+
+// bus time is set at once if it is further than this from a sync message
+#define STEP_THRESHOLD_US 10000
+
+// fraction of a backward correction applied with each sync message
+#define BACKWARD_SMOOTHING 16
+
+// the cycle counter wraps around in less than a minute: the anchor is
+// moved forward before the difference from it overflows an int32_t
+#define ANCHOR_MAX_AGE_MS 10000
+
+static struct {
+    bool synced;
+
+    // bus time at a known value of the cycle counter
+    uint64_t anchor_us;
+    uint32_t anchor_cycles;
+    uint32_t anchor_ms;
+
+    uint32_t rate; // cycles per microsecond, as 16.16 fixed point
+    bool rate_measured;
+
+    // last sync message, to measure the rate
+    uint64_t last_host_us;
+    uint32_t last_cycles;
+    uint32_t last_ms;
+
+    uint32_t messages;
+    int32_t  last_error_us;
+} state;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t get_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline uint32_t nominal_rate(void) {
+    return (uint64_t) up_perf_getfreq() * 65536 / 1000000;
+}
+
+static uint64_t to_bus_time(uint32_t cycles) {
+    const int32_t elapsed = cycles - state.anchor_cycles;
+    return state.anchor_us + (int64_t) elapsed * 65536 / state.rate;
+}
+
+// Keeps the anchor recent enough for the cycle counter to be compared
+// with it. Must be called with the lock held.
+static void update_anchor(void) {
+    const uint32_t now_ms = get_ms();
+
+    // bus time starts from boot
+    if(state.rate == 0) {
+        state.rate          = nominal_rate();
+        state.anchor_cycles = up_perf_gettime();
+        state.anchor_us     = (uint64_t) now_ms * 1000;
+        state.anchor_ms     = now_ms;
+        return;
+    }
+
+    if(now_ms - state.anchor_ms < ANCHOR_MAX_AGE_MS)
+        return;
+
+    // if the counter may have wrapped around, use the coarser clock
+    const uint32_t cycles = up_perf_gettime();
+    if(now_ms - state.anchor_ms < 2 * ANCHOR_MAX_AGE_MS)
+        state.anchor_us = to_bus_time(cycles);
+    else
+        state.anchor_us += (
+            (uint64_t) (now_ms - state.anchor_ms) * 1000 *
+            nominal_rate() / state.rate
+        );
+    state.anchor_cycles = cycles;
+    state.anchor_ms     = now_ms;
+
+    if(state.synced && now_ms - state.last_ms >= SYNC_TIMEOUT_MS)
+        state.synced = false;
+}
+
+static void update_rate(uint64_t host_us, uint32_t cycles,
+                        uint32_t now_ms) {
+    const uint32_t interval_ms = now_ms - state.last_ms;
+    if(state.messages == 0 ||
+       interval_ms < RATE_MIN_INTERVAL_MS ||
+       interval_ms > RATE_MAX_INTERVAL_MS ||
+       host_us <= state.last_host_us)
+        return;
+
+    const uint32_t rate = (
+        (uint64_t) (cycles - state.last_cycles) * 65536 /
+        (host_us - state.last_host_us)
+    );
+
+    // a message may have been delayed, or the user device's clock set
+    const uint32_t nominal = nominal_rate();
+    const int32_t max_difference = (
+        (uint64_t) nominal * RATE_MAX_DRIFT_PPM / 1000000
+    );
+    if(abs((int32_t) (rate - nominal)) > max_difference)
+        return;
+
+    // smooth out the jitter of the reception time
+    if(state.rate_measured)
+        state.rate += ((int32_t) (rate - state.rate)) / RATE_SMOOTHING;
+    else
+        state.rate = rate;
+    state.rate_measured = true;
+}
+
+void sync_handle(uint64_t host_us, uint32_t cycles) {
+    const uint32_t now_ms = get_ms();
+
+    pthread_mutex_lock(&lock);
+    update_anchor();
+    update_rate(host_us, cycles, now_ms);
+
+    // Messages are read some time after they arrive, so bus time
+    // appears ahead of the user device by that delay. Corrections
+    // forward are applied in full, those backward only in part, so
+    // that bus time settles on the messages read with the least delay.
+    const int64_t error = host_us - to_bus_time(cycles);
+    int64_t correction = error;
+    if(state.synced && error < 0 && -error <= STEP_THRESHOLD_US)
+        correction = error / BACKWARD_SMOOTHING;
+
+    state.anchor_us     = to_bus_time(cycles) + correction;
+    state.anchor_cycles = cycles;
+    state.anchor_ms     = now_ms;
+
+    state.synced        = true;
+    state.last_host_us  = host_us;
+    state.last_cycles   = cycles;
+    state.last_ms       = now_ms;
+    state.last_error_us = error;
+    state.messages++;
+    pthread_mutex_unlock(&lock);
+}
+
+bool sync_get_time(uint32_t cycles, uint64_t *time_us) {
+    pthread_mutex_lock(&lock);
+    update_anchor();
+    *time_us = to_bus_time(cycles);
+    const bool synced = state.synced;
+    pthread_mutex_unlock(&lock);
+    return synced;
+}
+
+void sync_print(void) {
+    pthread_mutex_lock(&lock);
+    update_anchor();
+    const uint64_t now_us = to_bus_time(up_perf_gettime());
+    const bool synced = state.synced;
+    const uint32_t messages = state.messages;
+    const int32_t error_us = state.last_error_us;
+    const int32_t drift_ppm = (
+        ((int64_t) state.rate - nominal_rate()) * 1000000 / nominal_rate()
+    );
+    pthread_mutex_unlock(&lock);
+
+    printf("bus time:       %llu us\n", (unsigned long long) now_us);
+    printf("synced:         %s\n", synced ? "yes" : "no");
+    printf("sync messages:  %lu\n", (unsigned long) messages);
+    printf("last error:     %ld us\n", (long) error_us);
+    printf("clock drift:    %ld ppm\n", (long) drift_ppm);
+}
@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* Copyright 2025 Rocco Rusponi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "timing.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <nuttx/arch.h>
+
+static const char *stage_names[TIMING_STAGE_COUNT] = {
+    "acquire", "transmit"
+};
+
+static struct {
+    uint32_t start;
+    uint32_t count; // completed iterations
+    uint64_t busy;  // cycles spent inside the stage
+} stages[TIMING_STAGE_COUNT];
+
+static int      active; // bitmask of running stages
+static uint32_t overlap_start;
+static uint64_t overlap; // cycles during which all stages were running
+
+static struct timespec reset_time;
+
+// incremented by each reset of the cycle profiles
+static volatile uint32_t profile_generation;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define ALL_STAGES ((1 << TIMING_STAGE_COUNT) - 1)
+
+void timing_begin(int stage) {
+    const uint32_t now = up_perf_gettime();
+
+    pthread_mutex_lock(&lock);
+    stages[stage].start = now;
+
+    active |= (1 << stage);
+    if(active == ALL_STAGES)
+        overlap_start = now;
+    pthread_mutex_unlock(&lock);
+}
+
+void timing_end(int stage, bool completed) {
+    const uint32_t now = up_perf_gettime();
+
+    pthread_mutex_lock(&lock);
+    stages[stage].busy += (uint32_t) (now - stages[stage].start);
+    if(completed)
+        stages[stage].count++;
+
+    if(active == ALL_STAGES)
+        overlap += (uint32_t) (now - overlap_start);
+    active &= ~(1 << stage);
+    pthread_mutex_unlock(&lock);
+}
+
+static inline unsigned long cycles_to_us(uint64_t cycles) {
+    return cycles / (up_perf_getfreq() / 1000000);
+}
+
+void timing_print(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    const uint64_t elapsed_us =
+        (uint64_t) (now.tv_sec - reset_time.tv_sec) * 1000000 +
+        (now.tv_nsec - reset_time.tv_nsec) / 1000;
+
+    pthread_mutex_lock(&lock);
+    printf("elapsed: %lu ms\n", (unsigned long) (elapsed_us / 1000));
+    for(int i = 0; i < TIMING_STAGE_COUNT; i++) {
+        const unsigned long busy_us = cycles_to_us(stages[i].busy);
+        const unsigned long count = stages[i].count;
+
+        printf(
+            "%-9s %lu iterations, busy %lu us (%lu us/iteration, %lu%%)\n",
+            stage_names[i], count, busy_us,
+            count ? busy_us / count : 0,
+            elapsed_us ? (unsigned long) (busy_us * 100 / elapsed_us) : 0
+        );
+    }
+
+    // overlap, relative to the time spent in the shorter stage
+    const uint64_t shortest = (
+        stages[0].busy < stages[1].busy ? stages[0].busy : stages[1].busy
+    );
+    printf(
+        "overlap:  %lu us (%lu%% of the shorter stage)\n",
+        cycles_to_us(overlap),
+        shortest ? (unsigned long) (overlap * 100 / shortest) : 0
+    );
+    pthread_mutex_unlock(&lock);
+}
+
+void timing_reset(void) {
+    pthread_mutex_lock(&lock);
+    memset(stages, 0, sizeof(stages));
+    overlap = 0;
+    clock_gettime(CLOCK_MONOTONIC, &reset_time);
+    pthread_mutex_unlock(&lock);
+
+    // profiles are cleared by their writer
+    profile_generation++;
+}
+
+/* ================================================================== */
+/*                           Cycle profile                            */
+/* ================================================================== */
+
+static const char *profile_names[TIMING_PROFILE_COUNT] = {
+    "read", "process", "threshold", "write"
+};
+
+// 'sequence' is odd while the writer is updating the profile
+static struct {
+    volatile uint32_t sequence;
+    uint32_t generation;
+    struct timing_profile data;
+} profiles[TIMING_PROFILE_COUNT];
+
+static inline int get_bucket(uint32_t cycles) {
+    const int bits = (cycles == 0 ? 0 : 32 - __builtin_clz(cycles));
+    if(bits <= 8)
+        return 0;
+    if(bits - 8 >= TIMING_HISTOGRAM_BUCKETS)
+        return TIMING_HISTOGRAM_BUCKETS - 1;
+    return bits - 8;
+}
+
+uint32_t timing_profile_begin(void) {
+    return up_perf_gettime();
+}
+
+void timing_profile_end(int profile, uint32_t start) {
+    const uint32_t cycles = up_perf_gettime() - start;
+
+    profiles[profile].sequence++;
+    __sync_synchronize();
+
+    // clear the profile if it was reset since the last update
+    struct timing_profile *data = &profiles[profile].data;
+    if(profiles[profile].generation != profile_generation) {
+        profiles[profile].generation = profile_generation;
+        memset(data, 0, sizeof(*data));
+    }
+
+    if(data->count == 0 || cycles < data->min)
+        data->min = cycles;
+    if(cycles > data->max)
+        data->max = cycles;
+    data->count++;
+    data->total += cycles;
+    data->histogram[get_bucket(cycles)]++;
+
+    __sync_synchronize();
+    profiles[profile].sequence++;
+}
+
+void timing_profile_read(int profile, struct timing_profile *data) {
+    uint32_t sequence;
+    bool current;
+
+    // if the writer was interrupted while updating, let it finish
+    while(true) {
+        sequence = profiles[profile].sequence;
+        __sync_synchronize();
+
+        *data   = profiles[profile].data;
+        current = (profiles[profile].generation == profile_generation);
+
+        __sync_synchronize();
+        if(!(sequence & 1) && sequence == profiles[profile].sequence)
+            break;
+        sched_yield();
+    }
+
+    // a profile not updated since the last reset is empty
+    if(!current)
+        memset(data, 0, sizeof(*data));
+}
+
+void timing_profile_print(void) {
+    printf("cycles per us: %lu\n", up_perf_getfreq() / 1000000);
+    for(int i = 0; i < TIMING_PROFILE_COUNT; i++) {
+        struct timing_profile data;
+        timing_profile_read(i, &data);
+
+        printf(
+            "%-9s %lu times, min %lu us, mean %lu us, max %lu us\n",
+            profile_names[i], (unsigned long) data.count,
+            cycles_to_us(data.min),
+            data.count ? cycles_to_us(data.total / data.count) : 0,
+            cycles_to_us(data.max)
+        );
+
+        // histogram, in cycles
+        for(int b = 0; b < TIMING_HISTOGRAM_BUCKETS; b++) {
+            if(data.histogram[b] == 0)
+                continue;
+
+            const unsigned long low = (b == 0 ? 0 : 1ul << (b + 7));
+            if(b == TIMING_HISTOGRAM_BUCKETS - 1)
+                printf("  %8lu+         ", low);
+            else
+                printf("  %8lu-%-8lu ", low, (1ul << (b + 8)) - 1);
+            printf("%lu\n", (unsigned long) data.histogram[b]);
+        }
+    }
+}
@@ -18,23 +18,81 @@
 #include "tof.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <nuttx/arch.h>
+#include <nuttx/ioexpander/gpio.h>
 
 #include "vl53l5cx_api.h"
+#include "decode.h"
+#include "storage.h"
+#include "log.h"
 
-int tof_matrix_width;
-static int tof_resolution;
+#define INTERRUPT_DEVICE "/dev/gpio0"
+#define INTERRUPT_SIGNAL SIGUSR1
 
-static VL53L5CX_Configuration config;
-static VL53L5CX_ResultsData results;
+#define WARM_BOOT_MAGIC 0x544f4657
+
+int tof_sensor_count = 1;
+
+struct tof_stats tof_stats;
+struct tof_boot_stats tof_boot_stats;
+
+// set by tof_set_i2c
+static int i2c_frequency  = 400000;
+static int i2c_chunk_size = 0;
+
+// set by tof_set_boot_i2c: frequency of the firmware upload (0 = as above)
+static int boot_i2c_frequency = 0;
+
+static int  interrupt_fd = -1;
+static bool interrupt_enabled = false;
+static volatile bool interrupt_flag = false;
+
+// cycle counter when the last interrupt was received, and when the one
+// that made the sensors in pending_checks pending was
+static volatile uint32_t interrupt_cycles;
+static uint32_t pending_cycles;
+
+// with a shared INT pin, sensors whose data-ready status is unknown
+static uint32_t pending_checks;
+
+static struct sensor {
+    VL53L5CX_Configuration config;
+    int resolution;
+    int matrix_width;
+    int outputs;
+} sensors[TOF_MAX_SENSORS];
+
+// frames are decoded one at a time, so all sensors share the output
+static struct decode_output results;
+
+// Kept across MCU resets that do not remove power (see the .noinit
+// section of the linker script). If valid, the sensors were initialized
+// with their own I2C address and may still be running their firmware.
+static struct {
+    uint32_t magic;
+    int  count;
+    bool ranging[TOF_MAX_SENSORS];
+} warm_state __attribute__((section(".noinit")));
+
+// defined in vl53l5cx_buffers.h
+extern const uint8_t VL53L5CX_DEFAULT_CONFIGURATION[];
+extern const uint8_t VL53L5CX_DEFAULT_XTALK[];
 
 extern void set_i2c_rst(bool on);
-extern void set_LPn(bool on);
+extern void set_LPn(int sensor, bool on);
 
+// Keeps all sensors disabled (LPn low): they are enabled one at a time
+// while assigning their I2C address.
 static inline void tof_reset(void) {
-    set_LPn(0);
+    for(int i = 0; i < TOF_MAX_SENSORS; i++)
+        set_LPn(i, 0);
     usleep(2000);
-    set_LPn(1);
 
     set_i2c_rst(0);
     usleep(2000);
@@ -44,136 +102,566 @@ static inline void tof_reset(void) {
     usleep(10000);
 }
 
-static inline int get_resolution_sqrt(void) {
-    switch(tof_resolution) {
+// The last sensor keeps the default address, so a single sensor is
+// never reassigned.
+static inline uint16_t get_address(int sensor) {
+    return VL53L5CX_DEFAULT_I2C_ADDRESS +
+           2 * (tof_sensor_count - 1 - sensor);
+}
+
+static inline int get_resolution_sqrt(int resolution) {
+    switch(resolution) {
         case VL53L5CX_RESOLUTION_4X4: return 4;
         case VL53L5CX_RESOLUTION_8X8: return 8;
     }
     return -1;
 }
 
-int tof_init(void) {
-    config.platform.address = VL53L5CX_DEFAULT_I2C_ADDRESS;
+// Output blocks, in the order of the VL53L5CX_OUTPUT_* bits (see
+// vl53l5cx_start_ranging)
+static const uint32_t output_blocks[] = {
+    VL53L5CX_START_BH,
+    VL53L5CX_METADATA_BH,
+    VL53L5CX_COMMONDATA_BH,
+    VL53L5CX_AMBIENT_RATE_BH,
+    VL53L5CX_SPAD_COUNT_BH,
+    VL53L5CX_NB_TARGET_DETECTED_BH,
+    VL53L5CX_SIGNAL_RATE_BH,
+    VL53L5CX_RANGE_SIGMA_MM_BH,
+    VL53L5CX_DISTANCE_BH,
+    VL53L5CX_REFLECTANCE_BH,
+    VL53L5CX_TARGET_STATUS_BH,
+    VL53L5CX_MOTION_DETECT_BH
+};
 
-    printf("[ToF] resetting sensor\n");
-    tof_reset();
+static uint32_t get_output_enable(int outputs) {
+    // the number of targets detected is needed to invalidate the status
+    // of zones without targets (see vl53l5cx_get_ranging_data)
+    uint32_t enable = (
+        VL53L5CX_OUTPUT_NB_TARGET_DETECTED |
+        VL53L5CX_OUTPUT_DISTANCE_MM | VL53L5CX_OUTPUT_TARGET_STATUS
+    );
+
+    if(outputs & TOF_OUTPUT_SIGMA)
+        enable |= VL53L5CX_OUTPUT_RANGE_SIGMA_MM;
+    if(outputs & TOF_OUTPUT_SIGNAL)
+        enable |= VL53L5CX_OUTPUT_SIGNAL_PER_SPAD;
+    return enable;
+}
+
+int tof_set_outputs(int sensor, int outputs) {
+    struct sensor *s = &sensors[sensor];
+
+    int err = 1;
+    if(outputs >= 0 && outputs < TOF_OUTPUT_PROFILE_COUNT) {
+        s->outputs = outputs;
+        s->config.platform.output_enable = get_output_enable(outputs);
+        err = 0;
+    }
+
+    printf(
+        "[ToF] setting outputs of sensor %d to 0x%x, %d bytes per frame "
+        "(err=%d)\n",
+        sensor, outputs, tof_get_frame_size(sensor, outputs), err
+    );
+    return err;
+}
+
+int tof_get_outputs(int sensor) {
+    return sensors[sensor].outputs;
+}
+
+int tof_get_frame_size(int sensor, int outputs) {
+    // same computation as vl53l5cx_start_ranging
+    const uint32_t enable = 0x7 | get_output_enable(outputs);
+    int size = 24;
+
+    for(int i = 0; i < sizeof(output_blocks) / sizeof(uint32_t); i++) {
+        if(!(enable & (1 << i)))
+            continue;
+
+        const union Block_header bh = { .bytes = output_blocks[i] };
+        if(bh.type >= 0x1 && bh.type < 0xd) {
+            int block_size = sensors[sensor].resolution;
+            if(bh.idx < 0x54d0 || bh.idx >= 0x54d0 + 960)
+                block_size *= VL53L5CX_NB_TARGET_PER_ZONE;
+            size += bh.type * block_size;
+        } else {
+            size += bh.size;
+        }
+        size += 4;
+    }
+    return size;
+}
+
+/* ================================================================== */
+/*                                Boot                                */
+/* ================================================================== */
+
+static int boot_phase = -1;
+static uint32_t boot_phase_start;
+
+static uint32_t get_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Ends the current boot phase (if any) and starts the given one
+static void begin_boot_phase(int phase) {
+    const uint32_t now = get_ms();
+    if(boot_phase >= 0)
+        tof_boot_stats.phase_ms[boot_phase] += now - boot_phase_start;
+
+    boot_phase = phase;
+    boot_phase_start = now;
+}
+
+// called by vl53l5cx_init
+static void boot_step(uint8_t step) {
+    begin_boot_phase(TOF_BOOT_PHASE_REBOOT + step);
+}
+
+// Restores the driver's state, if the sensor's firmware is still running
+static int warm_boot(int sensor) {
+    VL53L5CX_Configuration *config = &sensors[sensor].config;
+
+    if(warm_state.magic != WARM_BOOT_MAGIC ||
+       warm_state.count != tof_sensor_count)
+        return 1;
+
+    if(storage_read(STORAGE_KEY_OFFSET_DATA(sensor), config->offset_data,
+                    VL53L5CX_OFFSET_BUFFER_SIZE))
+        return 1;
+
+    // same as vl53l5cx_init
+    config->default_configuration = (uint8_t *) VL53L5CX_DEFAULT_CONFIGURATION;
+    config->default_xtalk         = (uint8_t *) VL53L5CX_DEFAULT_XTALK;
+    config->is_auto_stop_enabled  = 0;
+    memcpy(
+        config->xtalk_data, VL53L5CX_DEFAULT_XTALK, VL53L5CX_XTALK_BUFFER_SIZE
+    );
+
+    if(warm_state.ranging[sensor] && vl53l5cx_stop_ranging(config))
+        return 1;
+    warm_state.ranging[sensor] = false;
+
+    // check that the firmware answers
+    uint8_t resolution;
+    if(vl53l5cx_get_resolution(config, &resolution))
+        return 1;
+    return 0;
+}
+
+static int cold_boot(int sensor) {
+    VL53L5CX_Configuration *config = &sensors[sensor].config;
+
+    // use the cached offset data, if available
+    config->platform.offset_data_valid = !storage_read(
+        STORAGE_KEY_OFFSET_DATA(sensor), config->offset_data,
+        VL53L5CX_OFFSET_BUFFER_SIZE
+    );
+    tof_boot_stats.offset_cached &= config->platform.offset_data_valid;
+
+    if(vl53l5cx_init(config)) {
+        printf("[ToF] error initializing sensor %d\n", sensor);
+        return 1;
+    }
+
+    if(!config->platform.offset_data_valid) {
+        begin_boot_phase(TOF_BOOT_PHASE_CALIBRATION);
+        storage_write(
+            STORAGE_KEY_OFFSET_DATA(sensor), config->offset_data,
+            VL53L5CX_OFFSET_BUFFER_SIZE
+        );
+    }
+    return 0;
+}
+
+// Enables the sensor and moves it to its own I2C address. After an MCU
+// reset, the sensor may still have the address it was given before.
+static int detect(int sensor) {
+    VL53L5CX_Configuration *config = &sensors[sensor].config;
+    const uint16_t address = get_address(sensor);
+
+    set_LPn(sensor, 1);
+    usleep(2000);
 
-    // check if sensor is alive
     uint8_t is_alive;
-    if(vl53l5cx_is_alive(&config, &is_alive) || !is_alive) {
+    config->platform.address = address;
+    if(!vl53l5cx_is_alive(config, &is_alive) && is_alive)
+        return 0;
+
+    config->platform.address = VL53L5CX_DEFAULT_I2C_ADDRESS;
+    if(vl53l5cx_is_alive(config, &is_alive) || !is_alive) {
         printf(
-            "[ToF] sensor not detected at address 0x%x\n",
-            config.platform.address
+            "[ToF] sensor %d not detected at address 0x%x\n",
+            sensor, config->platform.address
         );
         return 1;
     }
-    printf("[ToF] sensor detected\n");
 
-    // initialize sensor
-    if(vl53l5cx_init(&config)) {
-        printf("[ToF] error initializing sensor\n");
+    // the firmware is lost if the address changed: boot cold
+    warm_state.magic = 0;
+
+    if(address != VL53L5CX_DEFAULT_I2C_ADDRESS &&
+       vl53l5cx_set_i2c_address(config, address)) {
+        printf(
+            "[ToF] error setting address of sensor %d to 0x%x\n",
+            sensor, address
+        );
         return 1;
     }
-    printf("[ToF] initialization complete\n");
+    return 0;
+}
+
+static int boot(int sensor) {
+    struct sensor *s = &sensors[sensor];
+    VL53L5CX_Configuration *config = &s->config;
+
+    config->platform.boot_step = boot_step;
+
+    // check if sensor is alive
+    begin_boot_phase(TOF_BOOT_PHASE_DETECT);
+    if(detect(sensor))
+        return 1;
+    printf(
+        "[ToF] sensor %d detected at address 0x%x\n",
+        sensor, config->platform.address
+    );
+
+    const bool fast = boot_i2c_frequency &&
+                      boot_i2c_frequency != i2c_frequency;
+    if(fast)
+        vl53l5cx_platform_set_transfer(boot_i2c_frequency, i2c_chunk_size);
+
+    // initialize sensor, unless its firmware is still running
+    begin_boot_phase(TOF_BOOT_PHASE_WARM_CHECK);
+    const bool warm = !warm_boot(sensor);
+    tof_boot_stats.warm &= warm;
+
+    int err = (warm ? 0 : cold_boot(sensor));
+    vl53l5cx_platform_set_transfer(i2c_frequency, i2c_chunk_size);
+
+    // the bus may not be fit for the faster frequency: retry without it
+    if(err && fast) {
+        printf(
+            "[ToF] retrying boot of sensor %d at %dHz\n",
+            sensor, i2c_frequency
+        );
+        err = cold_boot(sensor);
+    }
+    if(err)
+        return 1;
+    printf("[ToF] initialization of sensor %d complete\n", sensor);
 
     // set sensor's ranging mode to continuous
-    if(vl53l5cx_set_ranging_mode(&config, VL53L5CX_RANGING_MODE_CONTINUOUS)) {
+    begin_boot_phase(TOF_BOOT_PHASE_SETUP);
+    if(vl53l5cx_set_ranging_mode(config, VL53L5CX_RANGING_MODE_CONTINUOUS)) {
         printf("[ToF] error setting ranging mode\n");
         return 1;
     }
 
     // get default resolution
     uint8_t resolution;
-    if(vl53l5cx_get_resolution(&config, &resolution)) {
+    if(vl53l5cx_get_resolution(config, &resolution)) {
         printf("[ToF] error getting default resolution\n");
         return 1;
     }
 
-    tof_resolution   = resolution;
-    tof_matrix_width = get_resolution_sqrt();
+    s->resolution   = resolution;
+    s->matrix_width = get_resolution_sqrt(resolution);
+
+    config->platform.output_enable = get_output_enable(s->outputs);
     return 0;
 }
 
-void tof_start_ranging(void) {
-    while(vl53l5cx_start_ranging(&config)) {
+int tof_init(int count) {
+    if(count < 1 || count > TOF_MAX_SENSORS) {
+        printf("[ToF] invalid sensor count %d\n", count);
+        return 1;
+    }
+    tof_sensor_count = count;
+
+    memset(&tof_boot_stats, 0, sizeof(tof_boot_stats));
+    tof_boot_stats.warm          = true;
+    tof_boot_stats.offset_cached = true;
+    const uint32_t start = get_ms();
+
+    begin_boot_phase(TOF_BOOT_PHASE_RESET);
+    printf("[ToF] resetting sensors\n");
+    tof_reset();
+
+    int err = 0;
+    for(int i = 0; i < count && !err; i++)
+        err = boot(i);
+    begin_boot_phase(-1);
+
+    // the sensors' state is valid, unless the boot failed
+    warm_state.magic = (err ? 0 : WARM_BOOT_MAGIC);
+    warm_state.count = count;
+
+    tof_boot_stats.total_ms = get_ms() - start;
+    printf(
+        "[ToF] %s boot of %d sensor(s) took %lums (err=%d)\n",
+        tof_boot_stats.warm ? "warm" : "cold", count,
+        (unsigned long) tof_boot_stats.total_ms, err
+    );
+    return err;
+}
+
+int tof_clear_boot_cache(void) {
+    int err = 0;
+    for(int i = 0; i < TOF_MAX_SENSORS; i++)
+        err |= storage_erase(STORAGE_KEY_OFFSET_DATA(i));
+    return err;
+}
+
+int tof_get_matrix_width(int sensor) {
+    return sensors[sensor].matrix_width;
+}
+
+/* ================================================================== */
+/*                              Ranging                               */
+/* ================================================================== */
+
+void tof_start_ranging(int sensor) {
+    warm_state.ranging[sensor] = true;
+    while(vl53l5cx_start_ranging(&sensors[sensor].config)) {
         printf("[ToF] error in vl53l5cx_start_ranging, retrying\n");
         usleep(1000); // wait 1ms
     }
 }
 
-void tof_stop_ranging(void) {
-    while(vl53l5cx_stop_ranging(&config)) {
+void tof_stop_ranging(int sensor) {
+    while(vl53l5cx_stop_ranging(&sensors[sensor].config)) {
         printf("[ToF] error in vl53l5cx_stop_ranging, retrying\n");
         usleep(1000); // wait 1ms
     }
+    warm_state.ranging[sensor] = false;
 }
 
-int tof_set_resolution(int resolution) {
-    tof_resolution   = resolution;
-    tof_matrix_width = get_resolution_sqrt();
+int tof_set_resolution(int sensor, int resolution) {
+    struct sensor *s = &sensors[sensor];
+
+    int err = vl53l5cx_set_resolution(&s->config, resolution);
+    if(!err) {
+        s->resolution   = resolution;
+        s->matrix_width = get_resolution_sqrt(resolution);
+    }
 
-    int err = vl53l5cx_set_resolution(&config, resolution);
     printf(
-        "[ToF] setting resolution to %d (err=%d)\n",
-        resolution, err
+        "[ToF] setting resolution of sensor %d to %d (err=%d)\n",
+        sensor, resolution, err
     );
     return err;
 }
 
-int tof_read_data(int16_t **matrix, uint8_t **status_matrix) {
+// Sets 'captured' to the cycle counter when the data became ready, as
+// close as it is known
+static int check_data_ready(int sensor, uint32_t *captured) {
     uint8_t is_ready;
 
+    // if the interrupt is enabled, the INT pin tells when data is ready
+    if(interrupt_enabled) {
+        if(interrupt_flag) {
+            interrupt_flag = false;
+            pending_checks = (1 << tof_sensor_count) - 1;
+            pending_cycles = interrupt_cycles;
+        }
+
+        if(!(pending_checks & (1 << sensor)))
+            return 1;
+        pending_checks &= ~(1 << sensor);
+        *captured = pending_cycles;
+
+        // a single sensor drives the INT pin alone
+        if(tof_sensor_count == 1)
+            return 0;
+    } else {
+        *captured = up_perf_gettime();
+    }
+
     // check if data is ready
-    if(vl53l5cx_check_data_ready(&config, &is_ready)) {
-        printf("[ToF] error in vl53l5cx_check_data_ready\n");
+    tof_stats.ready_checks++;
+    if(vl53l5cx_check_data_ready(&sensors[sensor].config, &is_ready)) {
+        LOG(LOG_EVENT_READY_CHECK_ERROR, sensor);
         return 1;
     }
 
     // if data is not ready, return
-    if(!is_ready)
+    if(!is_ready) {
+        tof_stats.ready_misses++;
         return 1;
+    }
+    return 0;
+}
 
-    // read ranging data
-    if(vl53l5cx_get_ranging_data(&config, &results)) {
-        printf("[ToF] error in vl53l5cx_get_ranging_data\n");
+int tof_read_data(int sensor, struct tof_data *data) {
+    if(check_data_ready(sensor, &data->captured))
         return 1;
-    }
 
-    #if VL53L5CX_NB_TARGET_PER_ZONE == 1
-        *matrix = results.distance_mm;
-        *status_matrix = results.target_status;
-    #else
-        static int16_t _matrix[64];
-        static uint8_t _status_matrix[64];
+    VL53L5CX_Configuration *config = &sensors[sensor].config;
 
-        for(int i = 0; i < tof_resolution; i++) {
-            const int results_index = i * VL53L5CX_NB_TARGET_PER_ZONE;
+    const struct vl53l5cx_i2c_stats i2c_before = vl53l5cx_i2c_stats;
 
-            _matrix[i] = results.distance_mm[results_index];
-            _status_matrix[i] = results.target_status[results_index];
-        }
+    // read ranging data (see vl53l5cx_get_ranging_data)
+    if(VL53L5CX_RdMulti(&config->platform, 0x0,
+                        config->temp_buffer, config->data_read_size)) {
+        LOG(LOG_EVENT_READ_ERROR, sensor);
+        return 1;
+    }
+    config->streamcount = config->temp_buffer[0];
+
+    if(decode_frame(config->temp_buffer, config->data_read_size,
+                    sensors[sensor].resolution, &results)) {
+        LOG(LOG_EVENT_CORRUPTED_FRAME, sensor);
+        return 1;
+    }
+    tof_stats.frames++;
+    tof_stats.frame_i2c_transactions = (
+        vl53l5cx_i2c_stats.transactions - i2c_before.transactions
+    );
+    tof_stats.frame_i2c_bytes = (
+        vl53l5cx_i2c_stats.bytes - i2c_before.bytes
+    );
 
-        *matrix = _matrix;
-        *status_matrix = _status_matrix;
-    #endif
+    // the targets of each zone are read in place
+    data->stride          = VL53L5CX_NB_TARGET_PER_ZONE;
+    data->distance        = results.distance_mm;
+    data->status          = results.target_status;
+    data->sigma           = results.range_sigma_mm;
+    data->signal_per_spad = results.signal_per_spad;
+    data->nb_targets      = results.nb_target_detected;
 
     return 0;
 }
 
-int tof_set_frequency(int frequency_hz) {
-    int err = vl53l5cx_set_ranging_frequency_hz(&config, frequency_hz);
+int tof_set_frequency(int sensor, int frequency_hz) {
+    int err = vl53l5cx_set_ranging_frequency_hz(
+        &sensors[sensor].config, frequency_hz
+    );
+    printf(
+        "[ToF] setting frequency of sensor %d to %dHz (err=%d)\n",
+        sensor, frequency_hz, err
+    );
+    return err;
+}
+
+int tof_set_sharpener(int sensor, int sharpener_percent) {
+    int err = vl53l5cx_set_sharpener_percent(
+        &sensors[sensor].config, sharpener_percent
+    );
+    printf(
+        "[ToF] setting sharpener of sensor %d to %d%% (err=%d)\n",
+        sensor, sharpener_percent, err
+    );
+    return err;
+}
+
+int tof_set_i2c(int frequency, int chunk_size) {
+    int err = 1;
+    if(frequency > 0 && chunk_size >= 0)
+        err = vl53l5cx_platform_set_transfer(frequency, chunk_size);
+
+    if(!err) {
+        i2c_frequency  = frequency;
+        i2c_chunk_size = chunk_size;
+    }
+
     printf(
-        "[ToF] setting frequency to %dHz (err=%d)\n",
-        frequency_hz, err
+        "[ToF] setting I2C frequency to %dHz, chunk size to %d (err=%d)\n",
+        frequency, chunk_size, err
     );
     return err;
 }
 
-int tof_set_sharpener(int sharpener_percent) {
-    int err = vl53l5cx_set_sharpener_percent(&config, sharpener_percent);
+int tof_set_boot_i2c(int frequency) {
+    int err = 1;
+    if(frequency >= 0 && frequency <= 1000000) { // up to Fast-mode Plus
+        boot_i2c_frequency = frequency;
+        err = 0;
+    }
+
     printf(
-        "[ToF] setting sharpener to %d%% (err=%d)\n",
-        sharpener_percent, err
+        "[ToF] setting boot I2C frequency to %dHz (err=%d)\n",
+        frequency, err
     );
     return err;
 }
+
+uint32_t tof_get_i2c_errors(void) {
+    return vl53l5cx_i2c_stats.errors;
+}
+
+/* ================================================================== */
+/*                        Data-ready interrupt                        */
+/* ================================================================== */
+
+static void interrupt_handler(int signo, siginfo_t *info, void *context) {
+    interrupt_cycles = up_perf_gettime();
+    interrupt_flag = true;
+    tof_stats.interrupts++;
+}
+
+static int interrupt_setup(void) {
+    // open the GPIO device connected to the INT pin
+    interrupt_fd = open(INTERRUPT_DEVICE, O_RDWR);
+    if(interrupt_fd < 0) {
+        perror("[ToF] error opening " INTERRUPT_DEVICE);
+        return 1;
+    }
+
+    // install signal handler
+    struct sigaction act = {
+        .sa_sigaction = interrupt_handler,
+        .sa_flags     = SA_SIGINFO
+    };
+    sigemptyset(&act.sa_mask);
+    if(sigaction(INTERRUPT_SIGNAL, &act, NULL)) {
+        perror("[ToF] error in sigaction");
+        return 1;
+    }
+    return 0;
+}
+
+int tof_interrupt_enable(bool enable) {
+    if(enable && interrupt_fd < 0 && interrupt_setup())
+        return 1;
+
+    int err = 0;
+    if(enable) {
+        // ask the GPIO driver to notify the calling task
+        struct sigevent event = {
+            .sigev_notify = SIGEV_SIGNAL,
+            .sigev_signo  = INTERRUPT_SIGNAL
+        };
+        err = ioctl(interrupt_fd, GPIOC_REGISTER, (unsigned long) &event);
+    } else if(interrupt_fd >= 0) {
+        err = ioctl(interrupt_fd, GPIOC_UNREGISTER, 0);
+    }
+
+    if(!err) {
+        interrupt_enabled = enable;
+        interrupt_flag = false;
+        pending_checks = 0;
+
+        // Keep the signal blocked outside of waits (see can_io_wait), so
+        // that it cannot slip in between checking for pending data and
+        // starting to wait.
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, INTERRUPT_SIGNAL);
+        sigprocmask(enable ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+    }
+
+    printf(
+        "[ToF] %s data-ready interrupt (err=%d)\n",
+        enable ? "enabling" : "disabling", err
+    );
+    return (err != 0);
+}
+
+bool tof_interrupt_pending(void) {
+    return interrupt_flag || pending_checks != 0;
+}
@@ -349,6 +349,22 @@
 #define LPn      /* PA5 */ (GPIO_OUTPUT | GPIO_PUSHPULL | GPIO_SPEED_50MHz | GPIO_OUTPUT_CLEAR | \
                             GPIO_PORTA | GPIO_PIN5)
 
+/* LPn pins of additional VL53L5CX sensors sharing the I2C bus and INT pin */
+
+#define LPn1     /* PA8 */ (GPIO_OUTPUT | GPIO_PUSHPULL | GPIO_SPEED_50MHz | GPIO_OUTPUT_CLEAR | \
+                            GPIO_PORTA | GPIO_PIN8)
+#define LPn2     /* PB0 */ (GPIO_OUTPUT | GPIO_PUSHPULL | GPIO_SPEED_50MHz | GPIO_OUTPUT_CLEAR | \
+                            GPIO_PORTB | GPIO_PIN0)
+#define LPn3     /* PB1 */ (GPIO_OUTPUT | GPIO_PUSHPULL | GPIO_SPEED_50MHz | GPIO_OUTPUT_CLEAR | \
+                            GPIO_PORTB | GPIO_PIN1)
+#define TOF_INT  /* PA7 */ (GPIO_INPUT | GPIO_PULLUP | GPIO_EXTI | GPIO_PORTA | GPIO_PIN7)
+
+/* GPIO driver pins: the VL53L5CX INT line is exposed as /dev/gpio0 */
+
+#define BOARD_NGPIOIN     0
+#define BOARD_NGPIOOUT    0
+#define BOARD_NGPIOINT    1
+
 /* If CONFIG_ARCH_LEDS is defined, the usage by the board port is defined in
  * include/board.h and src/stm32_leds.c. The LEDs are used to encode OS-related
  * events as follows:
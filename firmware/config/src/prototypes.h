@@ -217,6 +217,10 @@ int stm32l4_qencoder_initialize(const char *devpath, int timer);
 
 #ifdef CONFIG_CAN
 int stm32l4_can_setup(void);
+int stm32l4_can_setfilters(const uint16_t *ids, const uint16_t *masks,
+                           int count);
+int stm32l4_can_getfilter(int index, uint16_t *id, uint16_t *mask);
+bool stm32l4_can_rxoverrun(void);
 #endif
 
 
@@ -60,6 +60,17 @@
 #  define HAVE_I2C_DRIVER 1
 #endif
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* LPn pin of each VL53L5CX sensor, see set_LPn() */
+
+static const uint32_t g_lpn[] =
+{
+  LPn, LPn1, LPn2, LPn3
+};
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -397,7 +408,8 @@ int board_app_initialize(uintptr_t arg)
 #endif
 
     stm32l4_configgpio(I2C_RST);
-    stm32l4_configgpio(LPn);
+    for (int i = 0; i < sizeof(g_lpn) / sizeof(g_lpn[0]); i++)
+        stm32l4_configgpio(g_lpn[i]);
     syslog(LOG_INFO, "CONFIGURATION COMPLETE\n");
 
     return ret;
@@ -409,9 +421,10 @@ void set_i2c_rst(bool on)
 }
 
 
-void set_LPn(bool on)
+void set_LPn(int sensor, bool on)
 {
-    stm32l4_gpiowrite(LPn, on);
+    if (sensor >= 0 && sensor < sizeof(g_lpn) / sizeof(g_lpn[0]))
+        stm32l4_gpiowrite(g_lpn[sensor], on);
 }
 
 
@@ -32,6 +32,7 @@
 
 #include <nuttx/can/can.h>
 
+#include "arm_internal.h"
 #include "stm32l4_can.h"
 #include "board.h"
 
@@ -49,6 +50,21 @@
 #  define CAN_PORT 1
 #endif
 
+/* The bxCAN of the L43x has 14 filter banks.  In 16-bit scale, each bank
+ * holds two filters made of an identifier and a mask.
+ */
+
+#define CAN_NBANKS         14
+#define CAN_NFILTERS       (2 * CAN_NBANKS)
+
+#define CAN_FILTER_REG(b,i) \
+  (STM32L4_CAN1_BASE + STM32L4_CAN_FIR_OFFSET(b, i))
+
+/* 16-bit filter format: STID[10:0] RTR IDE EXID[17:15] */
+
+#define CAN_FILTER16_STID_SHIFT 5
+#define CAN_FILTER16_IDE        (1 << 3)
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -93,4 +109,166 @@ int stm32l4_can_setup(void)
 #endif
 }
 
+/****************************************************************************
+ * Name: stm32l4_can_setfilters
+ *
+ * Description:
+ *   Replace the acceptance filters of CAN1.  A standard frame is received
+ *   if, for any filter, its identifier matches ids[i] in the bits set in
+ *   masks[i].  With no filters, all frames are received, as configured
+ *   by the CAN driver when the device is opened.
+ *
+ *   The filters are lost when the device is opened again, so this
+ *   function must be called afterwards.
+ *
+ * Returned Value:
+ *   OK on success, -E2BIG if there are more filters than the hardware
+ *   supports (in which case the filters are left unchanged).
+ *
+ ****************************************************************************/
+
+int stm32l4_can_setfilters(const uint16_t *ids, const uint16_t *masks,
+                           int count)
+{
+  uint32_t active = 0;
+  int bank;
+
+  if (count > CAN_NFILTERS)
+    {
+      return -E2BIG;
+    }
+
+  /* Reception is stopped while the filters are initialized */
+
+  modifyreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FMR_OFFSET, 0,
+              CAN_FMR_FINIT);
+
+  if (count == 0)
+    {
+      /* A single 32-bit filter with an empty mask accepts all frames */
+
+      putreg32(0, CAN_FILTER_REG(0, 1));
+      putreg32(0, CAN_FILTER_REG(0, 2));
+      modifyreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FS1R_OFFSET, 0, 1);
+      active = 1;
+    }
+  else
+    {
+      for (bank = 0; bank < (count + 1) / 2; bank++)
+        {
+          uint32_t fr[2];
+          int i;
+
+          for (i = 0; i < 2; i++)
+            {
+              /* Repeat the last filter if the count is odd.  Only
+               * standard frames are accepted.
+               */
+
+              int f = (2 * bank + i < count) ? 2 * bank + i : count - 1;
+              uint32_t id   = ids[f] << CAN_FILTER16_STID_SHIFT;
+              uint32_t mask = (masks[f] << CAN_FILTER16_STID_SHIFT) |
+                              CAN_FILTER16_IDE;
+
+              fr[i] = (mask << 16) | (id & mask);
+            }
+
+          putreg32(fr[0], CAN_FILTER_REG(bank, 1));
+          putreg32(fr[1], CAN_FILTER_REG(bank, 2));
+          active |= 1 << bank;
+        }
+
+      /* Mask mode, 16-bit scale, FIFO 0 */
+
+      modifyreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FS1R_OFFSET, active, 0);
+    }
+
+  modifyreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FM1R_OFFSET, active, 0);
+  modifyreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FFA1R_OFFSET, active, 0);
+  putreg32(active, STM32L4_CAN1_BASE + STM32L4_CAN_FA1R_OFFSET);
+
+  modifyreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FMR_OFFSET, CAN_FMR_FINIT,
+              0);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: stm32l4_can_getfilter
+ *
+ * Description:
+ *   Read back filter 'index' of CAN1 (two per bank), as the standard
+ *   identifier and mask it matches.
+ *
+ * Returned Value:
+ *   OK if the filter is active, -ENOENT if it is not, -ERANGE if the
+ *   index is out of range.
+ *
+ ****************************************************************************/
+
+int stm32l4_can_getfilter(int index, uint16_t *id, uint16_t *mask)
+{
+  int bank = index / 2;
+  uint32_t fr;
+
+  if (index < 0 || index >= CAN_NFILTERS)
+    {
+      return -ERANGE;
+    }
+
+  if (!(getreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FA1R_OFFSET) &
+        (1 << bank)))
+    {
+      return -ENOENT;
+    }
+
+  if (getreg32(STM32L4_CAN1_BASE + STM32L4_CAN_FS1R_OFFSET) & (1 << bank))
+    {
+      /* 32-bit scale: one filter per bank, STID in bits 31:21 */
+
+      if (index % 2 != 0)
+        {
+          return -ENOENT;
+        }
+
+      *id   = getreg32(CAN_FILTER_REG(bank, 1)) >> 21;
+      *mask = getreg32(CAN_FILTER_REG(bank, 2)) >> 21;
+    }
+  else
+    {
+      fr    = getreg32(CAN_FILTER_REG(bank, 1 + index % 2));
+      *id   = (fr & 0xffff) >> CAN_FILTER16_STID_SHIFT;
+      *mask = (fr >> 16) >> CAN_FILTER16_STID_SHIFT;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: stm32l4_can_rxoverrun
+ *
+ * Description:
+ *   Check whether receive FIFO 0 of CAN1 overran, losing a message, since
+ *   the last call.  The overrun flag is cleared.  The CAN driver does not
+ *   report overruns, so the flag has to be polled.
+ *
+ * Returned Value:
+ *   true if the FIFO overran, false otherwise.
+ *
+ ****************************************************************************/
+
+bool stm32l4_can_rxoverrun(void)
+{
+  uint32_t regaddr = STM32L4_CAN1_BASE + STM32L4_CAN_RF0R_OFFSET;
+
+  if (!(getreg32(regaddr) & CAN_RFR_FOVR))
+    {
+      return false;
+    }
+
+  /* The flag is cleared by writing 1, the other bits are left alone */
+
+  putreg32(CAN_RFR_FOVR, regaddr);
+  return true;
+}
+
 #endif /* CONFIG_CAN */
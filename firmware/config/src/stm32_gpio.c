@@ -54,8 +54,6 @@ struct stm32gpint_dev_s
   pin_interrupt_t callback;
 };
 
-#define BOARD_NGPIOOUT    3
-
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -133,7 +131,7 @@ static const struct gpio_operations_s gpint_ops =
 
 static const uint32_t g_gpiointinputs[BOARD_NGPIOINT] =
 {
-  GPIO_INT1,
+  TOF_INT,
 };
 
 static struct stm32gpint_dev_s g_gpint[BOARD_NGPIOINT];
@@ -239,10 +237,10 @@ static int gpint_enable(struct gpio_dev_s *dev, bool enable)
         {
           gpioinfo("Enabling the interrupt\n");
 
-          /* Configure the interrupt for rising edge */
+          /* Configure the interrupt for falling edge (INT is active low) */
 
           stm32l4_gpiosetevent(g_gpiointinputs[stm32gpint->stm32gpio.id],
-                               true, false, false, stm32gpio_interrupt,
+                               false, true, false, stm32gpio_interrupt,
                                &g_gpint[stm32gpint->stm32gpio.id]);
         }
     }
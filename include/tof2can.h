@@ -39,11 +39,19 @@ extern "C" {
 #define TOF2CAN_CONDITION_BELOW_THRESHOLD_EVENT 4
 #define TOF2CAN_CONDITION_ABOVE_THRESHOLD_EVENT 5
 
+#define TOF2CAN_ENCODING_DATA_PACKET   0
+#define TOF2CAN_ENCODING_PACKED_PACKET 1
+
 /*
  * struct tof2can_config (size = 8)
  *
  * Sent by the user device to the distance sensor to configure it. After
- * powering up, the sensor remains idle until being configured.
+ * powering up, the sensor applies the configuration stored in its flash
+ * (see struct tof2can_storage) and starts ranging. If none is stored,
+ * it remains idle until being configured.
+ *
+ * Ranging only stops while changing *resolution*, *frequency* or
+ * *sharpener*. Other settings are applied between two frames.
  *
  * resolution
  *     Number of sampled data points. Allowed values:
@@ -121,6 +129,11 @@ extern "C" {
  *     Threshold events happen when the *below_threshold* value changes:
  *     - if below_threshold = true, a 'below threshold event' happens
  *     - if below_threshold = false, an 'above threshold event' happens
+ *
+ * data_encoding:
+ *     How multiple samples are transmitted. Allowed values:
+ *     - 0=data packets (3 samples of 16 bits per packet)
+ *     - 1=packed packets (4 samples of 12 bits per packet)
  */
 
 #define TOF2CAN_CONFIG_SIZE 8
@@ -139,13 +152,275 @@ struct tof2can_config {
     // data transmission
     uint8_t transmit_timing    : 1; // 0=on-demand, 1=continuous
     uint8_t transmit_condition : 3; // see documentation above
+    uint8_t data_encoding      : 1; // 0=16-bit, 1=packed 12-bit
+};
+
+/*
+ * struct tof2can_ext_config (size = 8)
+ *
+ * Sent by the user device to the distance sensor to change a setting
+ * that does not fit in struct tof2can_config. Receiving a
+ * struct tof2can_config message that changes the ToF settings
+ * (resolution, frequency or sharpener), or the first one, resets all
+ * extended settings to their default value, so extended settings should
+ * be sent after it. Other changes keep them, except that a new
+ * *processing_mode* replaces the area and result selector of channel 0.
+ *
+ * key:
+ *     Which setting is being changed. The remaining bytes depend on the
+ *     value of *key*:
+ *
+ *     if key == TOF2CAN_EXT_DELTA:
+ *       Change-only (delta) transmission of batches, see the
+ *       documentation of struct tof2can_packed_packet. Disabled by
+ *       default.
+ *
+ *       enabled:
+ *           Whether delta transmission is enabled or not.
+ *
+ *       deadband:
+ *           Minimum change of a zone's distance, in millimeters, for the
+ *           zone to be transmitted again. A zone becoming valid or
+ *           invalid is always transmitted.
+ *
+ *       keyframe_interval:
+ *           One batch every *keyframe_interval* batches contains all
+ *           zones (keyframe). Must be at least 1.
+ *
+ *     if key == TOF2CAN_EXT_AREA:
+ *       Sets the processed area of a channel to any rectangle of the
+ *       matrix, replacing the area set by *processing_mode*. Both
+ *       corners are included in the area, and must be inside the matrix
+ *       (0...3 if resolution = 16, 0...7 if resolution = 64).
+ *
+ *       x0, y0:
+ *           Coordinates of the top-left corner.
+ *
+ *       x1, y1:
+ *           Coordinates of the bottom-right corner.
+ *
+ *       result_selector:
+ *           0=min, 1=max, 2=average, 3=all, 4=median, 5=percentile
+ *
+ *       channel:
+ *           The channel whose area is set, from 0 to 3. Channel 0 is
+ *           the one configured by struct tof2can_config.
+ *
+ *     if key == TOF2CAN_EXT_CHANNEL:
+ *       Configures an additional processing channel. All channels
+ *       process the same ToF data, each one with its own area, result
+ *       selector, threshold status and transmit condition, so a single
+ *       sensor can produce multiple results (e.g. the minimum distance
+ *       in the matrix and all distances in a row). Channel 0 is
+ *       configured by struct tof2can_config, channels 1 to 3 are
+ *       disabled by default.
+ *
+ *       Transmit timing, data encoding and delta transmission are
+ *       shared by all channels.
+ *
+ *       channel:
+ *           The channel being configured, from 1 to 3.
+ *
+ *       enabled:
+ *           Whether the channel is enabled or not.
+ *
+ *       id:
+ *           Channel ID, from 1 to 31. Messages carrying the channel's
+ *           data use this ID in place of the sensor ID, so it must not
+ *           be used by any other sensor or channel. Remote Transmit
+ *           Requests addressed to this ID are served by the channel
+ *           only, while requests addressed to the sensor ID are served
+ *           by channel 0.
+ *
+ *       processing_mode, threshold, threshold_delay, threshold_focus,
+ *       transmit_condition:
+ *           Same as in struct tof2can_config.
+ *
+ *     if key == TOF2CAN_EXT_SELECTOR:
+ *       Sets the result selector of a channel, keeping its area. Besides
+ *       the selectors of *processing_mode*, the median and any
+ *       percentile of the valid distances in the area can be selected.
+ *       Percentiles use the nearest-rank method, so the median of an
+ *       even number of distances is the lower of the two middle ones.
+ *
+ *       channel:
+ *           The channel whose result selector is set, from 0 to 3.
+ *
+ *       result_selector:
+ *           0=min, 1=max, 2=average, 3=all, 4=median, 5=percentile
+ *
+ *       percentile:
+ *           The percentile returned if result_selector = 5, from 0 to
+ *           100 (e.g. 10 for the 10th percentile).
+ *
+ *     if key == TOF2CAN_EXT_FILTER:
+ *       Sets which zones of the matrix are valid. Invalid zones are
+ *       excluded from all result selectors and threshold foci, and are
+ *       transmitted as invalid samples. The filter applies to all
+ *       channels.
+ *
+ *       accepted_statuses:
+ *           Bitmask of the valid target statuses reported by the ToF
+ *           sensor: bit N is set if status N is valid. By default, only
+ *           statuses 5 and 9 are valid (TOF2CAN_FILTER_DEFAULT_STATUSES).
+ *
+ *       max_sigma:
+ *           Maximum estimated range error (sigma) of valid zones, in
+ *           millimeters. If set to 0 (default), there is no limit.
+ *
+ *       min_signal:
+ *           Minimum return signal of valid zones, in kcps per SPAD. If
+ *           set to 0 (default), there is no limit.
+ *
+ *     if key == TOF2CAN_EXT_TEMPORAL:
+ *       Sets a filter smoothing each zone of the matrix over consecutive
+ *       frames, applied after the validity filter and before any
+ *       processing. Disabled by default.
+ *
+ *       mode:
+ *           0=none, 1=exponential moving average, 2=median
+ *
+ *       weight:
+ *           If mode = 1, weight of the newest frame in the average, out
+ *           of 256 (e.g. 64 for 25%). Zones becoming invalid restart
+ *           the average.
+ *
+ *       length:
+ *           If mode = 2, number of frames whose median is taken, from 1
+ *           to 7. A zone is valid if it was valid in most of them.
+ *
+ *     if key == TOF2CAN_EXT_TARGETS:
+ *       The ToF sensor reports up to two targets per zone (e.g. a glass
+ *       pane and the wall behind it). Sets which target of each zone is
+ *       processed: among the targets passing the validity filter, the
+ *       one chosen by *policy* is the primary target, and the best of
+ *       the others is the secondary target. Channels process the
+ *       primary target by default.
+ *
+ *       policy:
+ *           0=nearest (default), 1=strongest, 2=farthest. Strongest
+ *           compares the return signal of the targets.
+ *
+ *       secondary_channels:
+ *           Bitmask of the channels processing the secondary target:
+ *           bit N is set for channel N. Zones with a single valid
+ *           target are invalid in these channels. For example, to
+ *           stream both targets of each zone, set channel 0 and
+ *           channel 1 to the whole matrix with result selector 'all',
+ *           and set bit 1 of this mask; with delta transmission, zones
+ *           without a secondary target cost little bandwidth. The
+ *           temporal filter follows each target separately.
+ *
+ *     if key == TOF2CAN_EXT_TELEMETRY:
+ *       Periodic health and throughput reports, see the documentation
+ *       of struct tof2can_telemetry. Disabled by default.
+ *
+ *       interval_ms:
+ *           Time between two reports, in milliseconds (0=disabled).
+ *
+ *     if key == TOF2CAN_EXT_TIMESTAMPS:
+ *       Capture time of the data, see the documentation of
+ *       struct tof2can_timestamp. Disabled by default, as it doubles the
+ *       number of messages of single samples.
+ *
+ *       enabled:
+ *           Whether timestamps are sent or not.
+ */
+
+#define TOF2CAN_EXT_DELTA      0
+#define TOF2CAN_EXT_AREA       1
+#define TOF2CAN_EXT_CHANNEL    2
+#define TOF2CAN_EXT_SELECTOR   3
+#define TOF2CAN_EXT_FILTER     4
+#define TOF2CAN_EXT_TEMPORAL   5
+#define TOF2CAN_EXT_TARGETS    6
+#define TOF2CAN_EXT_TELEMETRY  7
+#define TOF2CAN_EXT_TIMESTAMPS 8
+
+#define TOF2CAN_FILTER_DEFAULT_STATUSES (1 << 5 | 1 << 9)
+
+#define TOF2CAN_TEMPORAL_NONE    0
+#define TOF2CAN_TEMPORAL_AVERAGE 1
+#define TOF2CAN_TEMPORAL_MEDIAN  2
+
+#define TOF2CAN_TEMPORAL_MAX_LENGTH 7
+
+#define TOF2CAN_TARGET_NEAREST   0
+#define TOF2CAN_TARGET_STRONGEST 1
+#define TOF2CAN_TARGET_FARTHEST  2
+
+#define TOF2CAN_EXT_CONFIG_SIZE 8
+struct tof2can_ext_config {
+    uint8_t key;
+    char _padding[1];
+
+    union {
+        struct {
+            bool     enabled;
+            uint8_t  keyframe_interval; // 1...255
+            uint16_t deadband;          // 0...4000mm
+        } delta;
+
+        struct {
+            uint8_t x0, y0;
+            uint8_t x1, y1;
+            uint8_t result_selector; // see documentation above
+            uint8_t channel;         // 0...3
+        } area;
+
+        struct {
+            uint8_t channel            : 2; // 1...3
+            uint8_t threshold_focus    : 2; // 0=min, 1=max, 2=avg, 3=sum
+            uint8_t transmit_condition : 3; // see tof2can_config
+            uint8_t enabled            : 1;
+
+            uint8_t  id;              // 1...31
+            uint8_t  processing_mode; // see tof2can_config
+            uint8_t  threshold_delay; // 0...255
+            uint16_t threshold;       // 0...4000mm
+        } channel;
+
+        struct {
+            uint8_t channel;         // 0...3
+            uint8_t result_selector; // see documentation above
+            uint8_t percentile;      // 0...100
+        } selector;
+
+        struct {
+            uint16_t accepted_statuses; // see documentation above
+            uint16_t max_sigma;         // mm, 0=no limit
+            uint16_t min_signal;        // kcps/SPAD, 0=no limit
+        } filter;
+
+        struct {
+            uint8_t mode;   // 0=none, 1=average, 2=median
+            uint8_t weight; // 1...255, out of 256
+            uint8_t length; // 1...7
+        } temporal;
+
+        struct {
+            uint8_t policy;             // 0=nearest, 1=strongest, 2=farthest
+            uint8_t secondary_channels; // bit N set for channel N
+        } targets;
+
+        struct {
+            uint16_t interval_ms; // 0=disabled
+        } telemetry;
+
+        struct {
+            bool enabled;
+        } timestamps;
+
+        uint8_t _raw[6];
+    };
 };
 
 /*
  * struct tof2can_sample (size = 4)
  *
  * Sent by the distance sensor when configured to obtain a single
- * distance sample.
+ * distance sample, after a struct tof2can_timestamp with the capture
+ * time of the sample.
  *
  * distance:
  *     The sample distance, in millimeters.
@@ -174,8 +449,10 @@ struct tof2can_sample {
  * packets organized in batches.
  *
  * A batch is assigned a batch ID, and all packets within it share the
- * same batch ID. Packets within a batch are assigned a sequence number
- * from 0 to N-1, with N being the total number of packets in the batch.
+ * same batch ID. Batches sent on the same CAN ID, in either encoding,
+ * are numbered consecutively (modulo 32). Packets within a batch are
+ * assigned a sequence number from 0 to N-1, with N being the total
+ * number of packets in the batch.
  *
  * Since N is not known beforehand, the last packet of a batch has the
  * 'last of batch' flag set. The receiver should set N to the last
@@ -237,13 +514,338 @@ struct tof2can_data_packet {
     int16_t data[3];
 };
 
+/*
+ * struct tof2can_packed_packet (size = 8)
+ *
+ * Sent by the distance sensor, as part of a batch of packets, when
+ * configured to obtain multiple distance samples using the packed data
+ * encoding. Batches of packed packets follow the same protocol as
+ * batches of data packets, except that packets contain from 1 to 4
+ * samples: the receiver should buffer the samples received, offset by
+ * (sequence_number * 4).
+ *
+ * sequence_number:
+ *     Identifier of the packet within its batch.
+ *
+ * data_length:
+ *     Number of data samples carried by the packet, from 1 to 4. Only
+ *     the last packet of a batch is allowed to contain less than 4.
+ *
+ * batch_id:
+ *     Identifier of the packet's batch.
+ *
+ * last_of_batch:
+ *     True if the packet is the last of its batch, false otherwise.
+ *
+ * data:
+ *     Array of 12-bit samples carried by the packet, measured in
+ *     millimeters. Sample N occupies bits [12*N, 12*N + 11] of the
+ *     array, read as a little-endian integer:
+ *
+ *       + Byte +- Bits 0-3 ------------+- Bits 4-7 ------------+
+ *       | 0    |  sample 0, bits 0-3   |  sample 0, bits 4-7   |
+ *       | 1    |  sample 0, bits 8-11  |  sample 1, bits 0-3   |
+ *       | 2    |  sample 1, bits 4-7   |  sample 1, bits 8-11  |
+ *       | 3-5  |  samples 2 and 3, as in bytes 0-2             |
+ *       +------+-----------------------+-----------------------+
+ *
+ *     Invalid samples are represented by the value 0xfff. Distances
+ *     greater than 4094mm are transmitted as 4094mm.
+ *
+ * delta:
+ *     True if the packet is part of a delta batch, false otherwise.
+ *
+ *
+ * Delta batches:
+ *   when delta transmission is enabled (see TOF2CAN_EXT_DELTA), the
+ *   sensor only transmits zones that changed since the last batch.
+ *   The 12-bit values carried by a delta batch are, in order:
+ *   - the total number of zones N
+ *   - the zone bitmap: ceil(N / 12) values, where bit B of value V is
+ *     set if zone (12 * V + B) is included in the batch
+ *   - the distance of each included zone, in increasing zone order
+ *
+ *   Zones not included keep the value of the previous batch. Batches
+ *   with the 'delta' flag cleared (keyframes) contain all zones.
+ *
+ *   If any batch is lost, the receiver cannot reconstruct delta batches
+ *   until the next keyframe.
+ */
+
+#define TOF2CAN_PACKED_PACKET_SIZE 8
+struct tof2can_packed_packet {
+    uint8_t sequence_number : 5;
+    uint8_t data_length     : 3;
+
+    uint8_t batch_id      : 5;
+    uint8_t last_of_batch : 1;
+    uint8_t delta         : 1;
+    uint8_t _unused       : 1;
+
+    uint8_t data[6];
+};
+
+#define TOF2CAN_PACKED_INVALID 0xfff
+
+/*
+ * struct tof2can_timestamp (size = 4)
+ *
+ * Sent by the distance sensor, on its timestamp ID, if enabled (see
+ * TOF2CAN_EXT_TIMESTAMPS): before each single sample and before the
+ * packets of each batch (of either encoding), so that the user device
+ * can tell when the data was captured, apart from when it arrived.
+ *
+ * batch_id:
+ *     Identifier of the batch the timestamp belongs to, or
+ *     TOF2CAN_TIMESTAMP_SAMPLE if it belongs to the next single sample.
+ *
+ * synced:
+ *     True if the sensor's bus time follows the user device's clock
+ *     (see struct tof2can_sync), false if it counts from the sensor's
+ *     boot.
+ *
+ * timestamp:
+ *     Bus time when the frame was read from the ToF sensor, in units of
+ *     TOF2CAN_TIMESTAMP_UNIT_US, modulo 65536 (about 6.5 seconds). The
+ *     receiver should take the latest time, not later than the arrival
+ *     of the message, with the same remainder.
+ */
+
+#define TOF2CAN_TIMESTAMP_UNIT_US 100
+#define TOF2CAN_TIMESTAMP_SAMPLE  0xff
+
+#define TOF2CAN_TIMESTAMP_SIZE 4
+struct tof2can_timestamp {
+    uint8_t  batch_id;
+    bool     synced;
+    uint16_t timestamp;
+};
+
+/*
+ * struct tof2can_sync (size = 8)
+ *
+ * Broadcast by the user device on TOF2CAN_SYNC_ID to set the bus time
+ * of all sensors, which timestamps their data. The message should be
+ * sent at once after being built, about once per second: sensors use
+ * consecutive messages to compensate the drift of their clock, and
+ * keep counting between messages. After 10 seconds without messages,
+ * sensors report their bus time as not synced.
+ *
+ * time_us:
+ *     Time of the user device's clock, in microseconds.
+ */
+
+#define TOF2CAN_SYNC_SIZE 8
+struct tof2can_sync {
+    uint64_t time_us;
+};
+
+/*
+ * struct tof2can_storage (size = 4)
+ *
+ * Sent by the user device to manage the configuration stored in the
+ * sensor's flash, and sent back by the sensor as a reply. The stored
+ * configuration is the last struct tof2can_config accepted, followed
+ * by the struct tof2can_ext_config messages accepted after it. If a
+ * configuration is stored, the sensor applies it at boot and starts
+ * streaming without waiting for the user device.
+ *
+ * command:
+ *     - 0 (save):  store the current configuration
+ *     - 1 (clear): remove the stored configuration
+ *     - 2 (read):  read back the stored configuration
+ *
+ * is_reply:
+ *     False if sent by the user device, true if sent by the sensor.
+ *
+ * error:
+ *     In replies, true if the command failed (e.g. reading when no
+ *     configuration is stored).
+ *
+ * count:
+ *     In replies to the read command, number of stored messages.
+ *
+ *
+ * Before replying to the read command, the sensor sends the stored
+ * messages, in order, on its storage ID: first the struct
+ * tof2can_config, then each struct tof2can_ext_config. These messages
+ * are 8 bytes long, so they can be told apart from replies.
+ */
+
+#define TOF2CAN_STORAGE_SAVE  0
+#define TOF2CAN_STORAGE_CLEAR 1
+#define TOF2CAN_STORAGE_READ  2
+
+#define TOF2CAN_STORAGE_SIZE 4
+struct tof2can_storage {
+    uint8_t command;
+    bool    is_reply;
+    bool    error;
+    uint8_t count;
+};
+
+/*
+ * struct tof2can_telemetry (size = 8)
+ *
+ * Sent by the distance sensor at the interval set through
+ * TOF2CAN_EXT_TELEMETRY, on its telemetry ID. A report is made of
+ * TOF2CAN_TELEMETRY_PAGE_COUNT messages, sent in order, each carrying
+ * three of the values listed below: value N is in page (N / 3), at
+ * index (N % 3).
+ *
+ * page:
+ *     Which values the message carries.
+ *
+ * sequence:
+ *     Identifier of the report, incremented by one with each report.
+ *
+ * values:
+ *     Three 16-bit values. Counters start at zero when the sensor boots
+ *     and wrap around: the receiver should accumulate the difference
+ *     from the previous report, modulo 65536. Counters marked as shared
+ *     count events of the whole device, so sensors driven by the same
+ *     device report the same value.
+ *
+ *     - 0 (frames acquired):   frames read from the ToF sensor
+ *     - 1 (frames sent):       batches or samples transmitted
+ *     - 2 (frames suppressed): data not transmitted because of the
+ *                              transmit condition
+ *     - 3 (CAN write errors):  failed writes to the CAN device (shared)
+ *     - 4 (I2C errors):        failed I2C transfers (shared)
+ *     - 5 (RX overruns):       times CAN messages were lost because the
+ *                              receive FIFO was full (shared)
+ *     - 6 (loop rate):         iterations per second of the main loop
+ *                              since the previous report (not a counter)
+ *     - 7 (TX dropped):        batches dropped from the transmit queue
+ *                              before being sent entirely (shared)
+ *     - 8 (uptime):            seconds since the sensor booted
+ */
+
+#define TOF2CAN_TELEMETRY_FRAMES_ACQUIRED   0
+#define TOF2CAN_TELEMETRY_FRAMES_SENT       1
+#define TOF2CAN_TELEMETRY_FRAMES_SUPPRESSED 2
+#define TOF2CAN_TELEMETRY_CAN_WRITE_ERRORS  3
+#define TOF2CAN_TELEMETRY_I2C_ERRORS        4
+#define TOF2CAN_TELEMETRY_RX_OVERRUNS       5
+#define TOF2CAN_TELEMETRY_LOOP_RATE         6
+#define TOF2CAN_TELEMETRY_TX_DROPPED        7
+#define TOF2CAN_TELEMETRY_UPTIME            8
+
+#define TOF2CAN_TELEMETRY_VALUE_COUNT 9
+#define TOF2CAN_TELEMETRY_PAGE_COUNT  3
+
+#define TOF2CAN_TELEMETRY_SIZE 8
+struct tof2can_telemetry {
+    uint8_t  page;
+    uint8_t  sequence;
+    uint16_t values[3];
+};
+
+/*
+ * struct tof2can_profile (size = 8)
+ *
+ * Sent by the distance sensor when the user device sends an RTR message
+ * on its profile ID. The reply describes how many CPU cycles the steps
+ * of each frame take, since boot or since the profile was last reset
+ * from the sensor's console. Each step is described by 25 16-bit words,
+ * sent in TOF2CAN_PROFILE_PAGE_COUNT messages of three words each; the
+ * messages are sent in order, step by step.
+ *
+ * step:
+ *     - 0 (read):      reading a frame from the ToF sensor
+ *     - 1 (process):   computing the result of a channel
+ *     - 2 (threshold): updating the threshold status of a channel
+ *     - 3 (write):     encoding and writing the CAN messages of a
+ *                      channel
+ *
+ * page:
+ *     Which words the message carries: word N is in page (N / 3), at
+ *     index (N % 3).
+ *
+ * words:
+ *     32-bit values are split in two words, the low word first.
+ *     - 0-1:  number of times the step was measured
+ *     - 2-3:  minimum, in cycles
+ *     - 4-5:  maximum, in cycles
+ *     - 6-7:  mean, in cycles
+ *     - 8:    cycles per microsecond
+ *     - 9-24: histogram, saturated at 65535. Bucket B counts durations
+ *             of [2^(B+7), 2^(B+8)) cycles; the first and last buckets
+ *             also count shorter and longer durations.
+ */
+
+#define TOF2CAN_PROFILE_STEP_READ      0
+#define TOF2CAN_PROFILE_STEP_PROCESS   1
+#define TOF2CAN_PROFILE_STEP_THRESHOLD 2
+#define TOF2CAN_PROFILE_STEP_WRITE     3
+
+#define TOF2CAN_PROFILE_STEP_COUNT   4
+#define TOF2CAN_PROFILE_BUCKET_COUNT 16
+#define TOF2CAN_PROFILE_WORD_COUNT   25
+#define TOF2CAN_PROFILE_PAGE_COUNT   9
+
+#define TOF2CAN_PROFILE_SIZE 8
+struct tof2can_profile {
+    uint8_t  step;
+    uint8_t  page;
+    uint16_t words[3];
+};
+
+/*
+ * struct tof2can_beacon (size = 4)
+ *
+ * Broadcast by the user device on TOF2CAN_BEACON_ID to divide the time
+ * in cycles of transmit slots, so that sensors do not compete for the
+ * bus. A cycle starts when the beacon is received, and more cycles
+ * follow back to back until the next beacon.
+ *
+ * Each sensor starts sending data (and telemetry reports) only in slot
+ * (sensor ID % slot_count), and only if the messages can be sent
+ * before the slot ends; data ready earlier waits for the slot. Data
+ * longer than a whole slot may be started anywhere in the slot, and
+ * runs over into the next one. Replies to requests are sent at once.
+ *
+ * If slot_count is greater than the highest sensor ID, slot 0 is free
+ * for the user device, e.g. to send the beacons. The sensor's system
+ * tick (10 ms by default) delays the start of its slot, so slots should
+ * be a few ticks longer than the data they carry.
+ *
+ * If no beacon is received for one second, or for two cycles if these
+ * are longer, sensors send data as soon as it is ready.
+ *
+ * slot_us:
+ *     Duration of each slot, in microseconds.
+ *
+ * slot_count:
+ *     Number of slots in a cycle. If 0, slots are disabled at once.
+ *
+ * sequence:
+ *     Incremented by one with each beacon.
+ */
+
+#define TOF2CAN_BEACON_SIZE 4
+struct tof2can_beacon {
+    uint16_t slot_us;
+    uint8_t  slot_count;
+    uint8_t  sequence;
+};
+
 // number of distinct sensor IDs (ID=0 is broadcast)
 #define TOF2CAN_MAX_SENSOR_COUNT 32
 
+#define TOF2CAN_SYNC_ID             0x620 // broadcast only
+#define TOF2CAN_TIMESTAMP_MASK_ID   0x640 // 0x640...0x65f
+#define TOF2CAN_BEACON_ID           0x660 // broadcast only
+#define TOF2CAN_PROFILE_MASK_ID     0x680 // 0x680...0x69f
+#define TOF2CAN_EXT_CONFIG_MASK_ID  0x6a0 // 0x6a0...0x6bf
 #define TOF2CAN_CONFIG_MASK_ID      0x6c0 // 0x6c0...0x6df
 #define TOF2CAN_SAMPLE_MASK_ID      0x6e0 // 0x6e0...0x6ff
 #define TOF2CAN_DATA_PACKET_MASK_ID 0x700 // 0x700...0x71f
 
+#define TOF2CAN_PACKED_PACKET_MASK_ID 0x720 // 0x720...0x73f
+#define TOF2CAN_STORAGE_MASK_ID       0x740 // 0x740...0x75f
+#define TOF2CAN_TELEMETRY_MASK_ID     0x760 // 0x760...0x77f
+
 #ifdef __cplusplus
 }
 #endif
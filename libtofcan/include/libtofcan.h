@@ -24,9 +24,18 @@ extern "C" {
 
 #include "tof2can.h"
 
+/*
+ * If 'has_time' is true, 'time_us' is when the data was captured, in
+ * the time of the clock set by 'libtofcan_set_clock'. The capture time
+ * is only known if the sensor sends timestamps (TOF2CAN_EXT_TIMESTAMPS)
+ * and is synced to that clock (see 'libtofcan_sync').
+ */
 struct libtofcan_sample {
     int16_t distance;
     bool below_threshold;
+
+    bool     has_time;
+    uint64_t time_us;
 };
 
 struct libtofcan_batch {
@@ -36,6 +45,66 @@ struct libtofcan_batch {
     int batch_id;
     int packets_received;
     int packets_expected;
+
+    bool     has_time;
+    uint64_t time_us;
+};
+
+// maximum number of extended settings a sensor can store
+#define LIBTOFCAN_STORAGE_MAX_EXT_CONFIGS 24
+
+/*
+ * Reply of a sensor to a storage command. If the command is
+ * TOF2CAN_STORAGE_READ and no error occurred, the stored configuration
+ * is also included.
+ */
+struct libtofcan_storage {
+    int  command;
+    bool error;
+
+    struct tof2can_config config;
+    struct tof2can_ext_config ext_configs[LIBTOFCAN_STORAGE_MAX_EXT_CONFIGS];
+    int ext_config_count;
+};
+
+/*
+ * Health and throughput counters of a sensor, accumulated from its
+ * telemetry reports (see struct tof2can_telemetry). Counters include
+ * the events that occurred before the first report was received,
+ * modulo 65536. Counters shared by the sensors of the same device are
+ * reported by each of them. When a sensor reboots (its uptime goes
+ * backwards), its counters start again from the values it reports.
+ * Reports missing a message are ignored.
+ */
+struct libtofcan_telemetry {
+    uint64_t frames_acquired;
+    uint64_t frames_sent;
+    uint64_t frames_suppressed;
+    uint64_t can_write_errors;
+    uint64_t i2c_errors;
+    uint64_t rx_overruns;
+    uint64_t tx_dropped;
+    uint64_t uptime; // seconds
+
+    int loop_rate; // main loop iterations per second
+    int reports;   // reports received
+};
+
+/*
+ * Cycle profile of the steps of each frame, sent by a sensor on request
+ * (see struct tof2can_profile). Steps are indexed by
+ * TOF2CAN_PROFILE_STEP_*.
+ */
+struct libtofcan_profile {
+    struct {
+        uint32_t count;
+        uint32_t min;  // cycles
+        uint32_t max;  // cycles
+        uint32_t mean; // cycles
+        uint32_t histogram[TOF2CAN_PROFILE_BUCKET_COUNT];
+    } steps[TOF2CAN_PROFILE_STEP_COUNT];
+
+    int cycles_per_us;
 };
 
 /*
@@ -53,6 +122,14 @@ struct libtofcan_msg {
  * sample or data batch. If the corresponding callback function is NULL,
  * data will instead be discarded.
  *
+ * Data of additional processing channels (see TOF2CAN_EXT_CHANNEL) is
+ * reported with the channel ID in place of the sensor ID.
+ *
+ * Delta batches (see TOF2CAN_EXT_DELTA) are reconstructed from the
+ * previous batch, so the batch callback always receives all zones. If
+ * a delta batch cannot be reconstructed because a previous batch was
+ * lost, it is reported as not valid.
+ *
  * Note that the data pointer's lifetime expires when the callback
  * function returns. DO NOT dereference the pointer outside the callback
  * function's scope. Copy the data instead.
@@ -62,18 +139,104 @@ extern void libtofcan_set_callbacks(
     void (*batch)(int sensor, struct libtofcan_batch *data, bool valid)
 );
 
+/*
+ * Sets the callback function to be called when a sensor replies to a
+ * storage command. If the callback function is NULL, replies will
+ * instead be discarded. The same lifetime rules of the data pointer
+ * apply as in 'libtofcan_set_callbacks'.
+ */
+extern void libtofcan_set_storage_callback(
+    void (*storage)(int sensor, struct libtofcan_storage *data)
+);
+
+/*
+ * Sets the callback function to be called when the last message of a
+ * telemetry report is received. If the callback function is NULL,
+ * counters are still updated. The same lifetime rules of the data
+ * pointer apply as in 'libtofcan_set_callbacks'.
+ */
+extern void libtofcan_set_telemetry_callback(
+    void (*telemetry)(int sensor, struct libtofcan_telemetry *data)
+);
+
+/*
+ * Copies the telemetry counters of the sensor with the specified ID.
+ * Returns false if no telemetry report was received from it.
+ */
+extern bool libtofcan_get_telemetry(int sensor,
+                                    struct libtofcan_telemetry *data);
+
+/*
+ * Sets the callback function to be called when a sensor replies to a
+ * profile request. If some messages of the reply were lost, the profile
+ * is reported as not valid. If the callback function is NULL, replies
+ * will instead be discarded. The same lifetime rules of the data
+ * pointer apply as in 'libtofcan_set_callbacks'.
+ */
+extern void libtofcan_set_profile_callback(
+    void (*profile)(int sensor, struct libtofcan_profile *data, bool valid)
+);
+
+/*
+ * Sets the clock of the user device, returning the time in microseconds
+ * (e.g. CLOCK_MONOTONIC). The clock is used to build sync messages and
+ * to report the capture time of samples and batches.
+ */
+extern void libtofcan_set_clock(uint64_t (*now_us)(void));
+
+/*
+ * Prepares a broadcast CAN message that sets the time of all sensors
+ * to the time of the clock (see struct tof2can_sync). The message
+ * should be sent at once, about once per second. Requires a clock to
+ * be set with 'libtofcan_set_clock'.
+ */
+extern void libtofcan_sync(struct libtofcan_msg *msg);
+
 /*
  * Prepares a CAN message to configure the sensor with the specified ID.
  */
 extern void libtofcan_config(int sensor, struct libtofcan_msg *msg,
                              struct tof2can_config *config);
 
+/*
+ * Prepares a CAN message to change an extended setting of the sensor
+ * with the specified ID. Extended settings are reset by configuring
+ * the sensor with 'libtofcan_config'.
+ */
+extern void libtofcan_ext_config(int sensor, struct libtofcan_msg *msg,
+                                 struct tof2can_ext_config *config);
+
 /*
  * Prepares a CAN message to request a sample or data batch from the
  * sensor with the specified ID.
  */
 extern void libtofcan_request(int sensor, struct libtofcan_msg *msg);
 
+/*
+ * Prepares a CAN message to save, clear or read back the configuration
+ * stored by the sensor with the specified ID. The command is one of
+ * TOF2CAN_STORAGE_SAVE, TOF2CAN_STORAGE_CLEAR, TOF2CAN_STORAGE_READ.
+ */
+extern void libtofcan_storage(int sensor, struct libtofcan_msg *msg,
+                              int command);
+
+/*
+ * Prepares a CAN message to request the cycle profile of the sensor
+ * with the specified ID.
+ */
+extern void libtofcan_profile_request(int sensor, struct libtofcan_msg *msg);
+
+/*
+ * Prepares a broadcast CAN message that divides the time in cycles of
+ * 'slot_count' transmit slots, each 'slot_us' microseconds long (see
+ * struct tof2can_beacon). Each sensor then sends its data only in slot
+ * (sensor ID % slot_count). The cycle starts when the message is sent:
+ * sending it at least once per second, at the start of a cycle, keeps
+ * sensors in step. If 'slot_count' is 0, slots are disabled.
+ */
+extern void libtofcan_beacon(struct libtofcan_msg *msg,
+                             int slot_count, int slot_us);
+
 /*
  * Handles a CAN message coming from a ToF sensor. If the message does
  * not come from a ToF sensor, no action is performed.
@@ -24,8 +24,13 @@
 struct {
     void (*sample)(int sensor, struct libtofcan_sample *data);
     void (*batch)(int sensor, struct libtofcan_batch *data, bool valid);
+    void (*storage)(int sensor, struct libtofcan_storage *data);
+    void (*telemetry)(int sensor, struct libtofcan_telemetry *data);
+    void (*profile)(int sensor, struct libtofcan_profile *data, bool valid);
 } callbacks;
 
+static uint64_t (*host_clock)(void);
+
 void libtofcan_set_callbacks(
     void (*sample)(int sensor, struct libtofcan_sample *data),
     void (*batch)(int sensor, struct libtofcan_batch *data, bool valid)
@@ -34,6 +39,28 @@ void libtofcan_set_callbacks(
     callbacks.batch = batch;
 }
 
+void libtofcan_set_storage_callback(
+    void (*storage)(int sensor, struct libtofcan_storage *data)
+) {
+    callbacks.storage = storage;
+}
+
+void libtofcan_set_telemetry_callback(
+    void (*telemetry)(int sensor, struct libtofcan_telemetry *data)
+) {
+    callbacks.telemetry = telemetry;
+}
+
+void libtofcan_set_profile_callback(
+    void (*profile)(int sensor, struct libtofcan_profile *data, bool valid)
+) {
+    callbacks.profile = profile;
+}
+
+void libtofcan_set_clock(uint64_t (*now_us)(void)) {
+    host_clock = now_us;
+}
+
 /* ================================================================== */
 /*                          config & request                          */
 /* ================================================================== */
@@ -46,12 +73,66 @@ void libtofcan_config(int sensor, struct libtofcan_msg *msg,
     memcpy(msg->data, config, TOF2CAN_CONFIG_SIZE);
 }
 
+void libtofcan_ext_config(int sensor, struct libtofcan_msg *msg,
+                          struct tof2can_ext_config *config) {
+    msg->id  = TOF2CAN_EXT_CONFIG_MASK_ID | sensor;
+    msg->rtr = false;
+    msg->len = TOF2CAN_EXT_CONFIG_SIZE;
+    memcpy(msg->data, config, TOF2CAN_EXT_CONFIG_SIZE);
+}
+
 void libtofcan_request(int sensor, struct libtofcan_msg *msg) {
     msg->id  = TOF2CAN_SAMPLE_MASK_ID | sensor;
     msg->rtr = true;
     msg->len = 0;
 }
 
+void libtofcan_storage(int sensor, struct libtofcan_msg *msg,
+                       int command) {
+    const struct tof2can_storage request = {
+        .command  = command,
+        .is_reply = false
+    };
+
+    msg->id  = TOF2CAN_STORAGE_MASK_ID | sensor;
+    msg->rtr = false;
+    msg->len = TOF2CAN_STORAGE_SIZE;
+    memcpy(msg->data, &request, TOF2CAN_STORAGE_SIZE);
+}
+
+void libtofcan_profile_request(int sensor, struct libtofcan_msg *msg) {
+    msg->id  = TOF2CAN_PROFILE_MASK_ID | sensor;
+    msg->rtr = true;
+    msg->len = 0;
+}
+
+void libtofcan_sync(struct libtofcan_msg *msg) {
+    const struct tof2can_sync sync = {
+        .time_us = (host_clock ? host_clock() : 0)
+    };
+
+    msg->id  = TOF2CAN_SYNC_ID;
+    msg->rtr = false;
+    msg->len = TOF2CAN_SYNC_SIZE;
+    memcpy(msg->data, &sync, TOF2CAN_SYNC_SIZE);
+}
+
+void libtofcan_beacon(struct libtofcan_msg *msg,
+                      int slot_count, int slot_us) {
+    static uint8_t sequence;
+
+    const struct tof2can_beacon beacon = {
+        .slot_us    = slot_us,
+        .slot_count = slot_count,
+        .sequence   = sequence++
+    };
+
+    msg->id  = TOF2CAN_BEACON_ID;
+    msg->rtr = false;
+    msg->len = TOF2CAN_BEACON_SIZE;
+    memcpy(msg->data, &beacon, TOF2CAN_BEACON_SIZE);
+}
+
 /* ================================================================== */
 /*                              receiver                              */
 /* ================================================================== */
@@ -67,36 +148,106 @@ static void publish_batch(int sensor, struct libtofcan_batch *data,
         callbacks.batch(sensor, data, valid);
 }
 
-static void handle_sample(int sensor, const void *data, int len) {
-    // check if message size is correct
-    if(len != TOF2CAN_SAMPLE_SIZE)
-        return;
+// Converts a timestamp sent by a sensor to the time of the host clock.
+// Returns false if the time is not known.
+static bool get_capture_time(bool synced, uint16_t timestamp,
+                             uint64_t *time_us) {
+    if(!synced || !host_clock)
+        return false;
+
+    // take the latest time, not later than now, with the same remainder
+    const uint64_t now = host_clock() / TOF2CAN_TIMESTAMP_UNIT_US;
+    const uint16_t age = (uint16_t) now - timestamp;
+    if(now < age)
+        return false;
+
+    *time_us = (now - age) * TOF2CAN_TIMESTAMP_UNIT_US;
+    return true;
+}
 
-    struct tof2can_sample sample;
-    memcpy(&sample, data, sizeof(sample));
+/*
+ * Information about a packet of a batch, common to all encodings.
+ */
+struct packet_info {
+    int sequence_number;
+    int batch_id;
+    bool last_of_batch;
+    bool delta;
+
+    int capacity; // maximum number of samples in a packet
+    int data_length;
+    int16_t data[4];
+};
+
+// zone count, zone bitmap and up to 64 samples
+#define DELTA_MAX_LENGTH (1 + 6 + 64)
+
+/*
+ * Reception state of the batches sent by a sensor.
+ */
+struct receiver {
+    struct libtofcan_batch batch;
 
-    publish_sample(sensor, &(struct libtofcan_sample) {
-        .distance = sample.distance,
-        .below_threshold = sample.below_threshold
-    });
-}
+    // capture time of the latest sample or batch announced
+    struct {
+        bool     received;
+        bool     has_time;
+        int      batch_id;
+        uint64_t time_us;
+    } timestamp;
+
+    // values carried by the delta batch being received
+    bool    delta;
+    int16_t delta_data[DELTA_MAX_LENGTH];
+
+    // last complete batch, which delta batches are applied to
+    int16_t reference[64];
+    int     reference_length;
+    bool    reference_valid;
+};
+
+static struct receiver receivers[TOF2CAN_MAX_SENSOR_COUNT];
+
+static void batch_reset(struct receiver *receiver,
+                        int sensor, const struct packet_info *packet) {
+    struct libtofcan_batch *batch = &receiver->batch;
 
-static void batch_reset(struct libtofcan_batch *batch,
-                        int sensor, int batch_id) {
     // if previous batch was interrupted, send it as invalid
-    if(batch->packets_received != batch->packets_expected)
+    if(batch->packets_received != batch->packets_expected) {
         publish_batch(sensor, batch, false);
 
+        // delta batches cannot be reconstructed until the next keyframe
+        receiver->reference_valid = false;
+    }
+
     batch->data_length      = 0;
-    batch->batch_id         = batch_id;
+    batch->batch_id         = packet->batch_id;
     batch->packets_received = 0;
     batch->packets_expected = 0;
+
+    // the timestamp is sent before the packets of the batch
+    batch->has_time = (
+        receiver->timestamp.received &&
+        receiver->timestamp.batch_id == packet->batch_id &&
+        receiver->timestamp.has_time
+    );
+    batch->time_us = receiver->timestamp.time_us;
+
+    receiver->delta = packet->delta;
 }
 
-static void batch_insert(struct libtofcan_batch *batch,
-                         struct tof2can_data_packet *packet) {
-    const int buffer_length = sizeof(batch->data) / sizeof(int16_t);
-    const int offset = packet->sequence_number * 3;
+static void batch_insert(struct receiver *receiver,
+                         const struct packet_info *packet) {
+    struct libtofcan_batch *batch = &receiver->batch;
+
+    int16_t *buffer = batch->data;
+    int buffer_length = sizeof(batch->data) / sizeof(int16_t);
+    if(receiver->delta) {
+        buffer = receiver->delta_data;
+        buffer_length = DELTA_MAX_LENGTH;
+    }
+
+    const int offset = packet->sequence_number * packet->capacity;
 
     // check if packet data would overflow the buffer
     if(offset + packet->data_length > buffer_length)
@@ -106,7 +257,7 @@ static void batch_insert(struct libtofcan_batch *batch,
     batch->packets_received++;
     batch->data_length += packet->data_length;
     memcpy(
-        &batch->data[offset],
+        &buffer[offset],
         &packet->data,
         packet->data_length * sizeof(int16_t)
     );
@@ -116,27 +267,393 @@ static void batch_insert(struct libtofcan_batch *batch,
         batch->packets_expected = 1 + packet->sequence_number;
 }
 
-static void handle_data_packet(int sensor, const void *data, int len) {
-    static struct libtofcan_batch batches[TOF2CAN_MAX_SENSOR_COUNT];
+static inline int16_t unpack_sample(uint16_t sample) {
+    return (sample == TOF2CAN_PACKED_INVALID ? -1 : sample);
+}
+
+static int delta_apply(struct receiver *receiver) {
+    struct libtofcan_batch *batch = &receiver->batch;
+    const int16_t *values = receiver->delta_data;
+    const int count = batch->data_length;
+
+    // check if the reference batch can be used
+    const int length = values[0];
+    if(!receiver->reference_valid || receiver->reference_length != length)
+        return 1;
+
+    const int bitmap_length = (length + 11) / 12;
+    if(count < 1 + bitmap_length)
+        return 1;
+
+    // start from the reference batch and replace changed zones
+    const int16_t *bitmap = &values[1];
+    int next = 1 + bitmap_length;
+    for(int i = 0; i < length; i++) {
+        if(bitmap[i / 12] & (1 << (i % 12))) {
+            if(next >= count)
+                return 1;
+            batch->data[i] = unpack_sample(values[next++]);
+        } else {
+            batch->data[i] = receiver->reference[i];
+        }
+    }
+    batch->data_length = length;
+    return 0;
+}
+
+static void batch_complete(struct receiver *receiver, int sensor) {
+    struct libtofcan_batch *batch = &receiver->batch;
+
+    bool valid = true;
+    if(receiver->delta)
+        valid = !delta_apply(receiver);
+
+    // update the reference batch
+    if(valid) {
+        memcpy(
+            receiver->reference, batch->data,
+            batch->data_length * sizeof(int16_t)
+        );
+        receiver->reference_length = batch->data_length;
+    }
+    receiver->reference_valid = valid;
+
+    publish_batch(sensor, batch, valid);
+}
+
+static void handle_packet(int sensor, const struct packet_info *packet) {
+    struct receiver *receiver = &receivers[sensor];
+
+    // if packet has a new batch ID, reset the batch buffer
+    if(receiver->batch.batch_id != packet->batch_id)
+        batch_reset(receiver, sensor, packet);
+
+    // insert new data into the batch buffer
+    batch_insert(receiver, packet);
 
+    // if all packets have been received, send the batch
+    const struct libtofcan_batch *batch = &receiver->batch;
+    if(batch->packets_received == batch->packets_expected)
+        batch_complete(receiver, sensor);
+}
+
+static void handle_timestamp(int sensor, const void *data, int len) {
+    // check if message size is correct
+    if(len != TOF2CAN_TIMESTAMP_SIZE)
+        return;
+
+    struct tof2can_timestamp timestamp;
+    memcpy(&timestamp, data, sizeof(timestamp));
+
+    struct receiver *receiver = &receivers[sensor];
+    receiver->timestamp.received = true;
+    receiver->timestamp.batch_id = timestamp.batch_id;
+    receiver->timestamp.has_time = get_capture_time(
+        timestamp.synced, timestamp.timestamp, &receiver->timestamp.time_us
+    );
+}
+
+static void handle_sample(int sensor, const void *data, int len) {
+    // check if message size is correct
+    if(len != TOF2CAN_SAMPLE_SIZE)
+        return;
+
+    struct tof2can_sample sample;
+    memcpy(&sample, data, sizeof(sample));
+
+    struct libtofcan_sample result = {
+        .distance = sample.distance,
+        .below_threshold = sample.below_threshold
+    };
+
+    // the timestamp is sent before the sample, and applies to it only
+    struct receiver *receiver = &receivers[sensor];
+    if(receiver->timestamp.received &&
+       receiver->timestamp.batch_id == TOF2CAN_TIMESTAMP_SAMPLE) {
+        result.has_time = receiver->timestamp.has_time;
+        result.time_us  = receiver->timestamp.time_us;
+        receiver->timestamp.received = false;
+    }
+    publish_sample(sensor, &result);
+}
+
+static void handle_data_packet(int sensor, const void *data, int len) {
     // check if message size is correct
     if(len != TOF2CAN_DATA_PACKET_SIZE)
         return;
 
-    struct libtofcan_batch *batch = &batches[sensor];
     struct tof2can_data_packet packet;
     memcpy(&packet, data, sizeof(packet));
 
-    // if packet has a new batch ID, reset the batch buffer
-    if(batch->batch_id != packet.batch_id)
-        batch_reset(batch, sensor, packet.batch_id);
+    struct packet_info info = {
+        .sequence_number = packet.sequence_number,
+        .batch_id        = packet.batch_id,
+        .last_of_batch   = packet.last_of_batch,
 
-    // insert new data into the batch buffer
-    batch_insert(batch, &packet);
+        .capacity    = 3,
+        .data_length = packet.data_length
+    };
+    memcpy(info.data, packet.data, sizeof(packet.data));
 
-    // if all packets have been received, send the batch
-    if(batch->packets_received == batch->packets_expected)
-        publish_batch(sensor, batch, true);
+    handle_packet(sensor, &info);
+}
+
+static void handle_packed_packet(int sensor, const void *data, int len) {
+    // check if message size is correct
+    if(len != TOF2CAN_PACKED_PACKET_SIZE)
+        return;
+
+    struct tof2can_packed_packet packet;
+    memcpy(&packet, data, sizeof(packet));
+
+    // check if data length is valid
+    if(packet.data_length > 4)
+        return;
+
+    struct packet_info info = {
+        .sequence_number = packet.sequence_number,
+        .batch_id        = packet.batch_id,
+        .last_of_batch   = packet.last_of_batch,
+
+        .delta           = packet.delta,
+
+        .capacity    = 4,
+        .data_length = packet.data_length
+    };
+
+    // unpack 12-bit values, two values (3 bytes) at a time
+    for(int s = 0; s < 4; s += 2) {
+        const uint8_t *bytes = &packet.data[s / 2 * 3];
+
+        info.data[s]     = bytes[0] | (bytes[1] & 0xf) << 8;
+        info.data[s + 1] = bytes[1] >> 4 | bytes[2] << 4;
+    }
+
+    // values of delta batches are decoded once the batch is complete
+    if(!packet.delta) {
+        for(int s = 0; s < 4; s++)
+            info.data[s] = unpack_sample(info.data[s]);
+    }
+
+    handle_packet(sensor, &info);
+}
+
+// stored messages read back so far, for each sensor
+static struct {
+    struct libtofcan_storage data;
+    int messages_received;
+} storage_readers[TOF2CAN_MAX_SENSOR_COUNT];
+
+static void handle_storage(int sensor, const void *data, int len) {
+    struct libtofcan_storage *storage = &storage_readers[sensor].data;
+    int *received = &storage_readers[sensor].messages_received;
+
+    // stored messages: first the config, then the extended settings
+    if(len == TOF2CAN_CONFIG_SIZE) {
+        if(*received == 0) {
+            memcpy(&storage->config, data, TOF2CAN_CONFIG_SIZE);
+        } else if(*received <= LIBTOFCAN_STORAGE_MAX_EXT_CONFIGS) {
+            memcpy(
+                &storage->ext_configs[*received - 1], data,
+                TOF2CAN_EXT_CONFIG_SIZE
+            );
+        }
+        (*received)++;
+        return;
+    }
+
+    // check if message size is correct
+    if(len != TOF2CAN_STORAGE_SIZE)
+        return;
+
+    struct tof2can_storage reply;
+    memcpy(&reply, data, sizeof(reply));
+
+    // ignore requests sent by other devices
+    if(!reply.is_reply)
+        return;
+
+    storage->command = reply.command;
+    storage->error   = reply.error;
+
+    if(reply.command == TOF2CAN_STORAGE_READ && !reply.error) {
+        // some stored messages were lost
+        if(*received != reply.count || reply.count == 0 ||
+           reply.count > LIBTOFCAN_STORAGE_MAX_EXT_CONFIGS + 1)
+            storage->error = true;
+        else
+            storage->ext_config_count = reply.count - 1;
+    }
+    if(storage->error || reply.command != TOF2CAN_STORAGE_READ)
+        storage->ext_config_count = 0;
+
+    if(callbacks.storage)
+        callbacks.storage(sensor, storage);
+
+    // start again with the next reply
+    *received = 0;
+}
+
+// telemetry values received so far, for each sensor
+static struct {
+    struct libtofcan_telemetry data;
+
+    uint64_t totals[TOF2CAN_TELEMETRY_VALUE_COUNT];
+    uint16_t last[TOF2CAN_TELEMETRY_VALUE_COUNT];
+    bool     received[TOF2CAN_TELEMETRY_VALUE_COUNT];
+
+    // pages of the report being received
+    uint16_t values[TOF2CAN_TELEMETRY_PAGE_COUNT * 3];
+    int      sequence;
+    int      pages_received;
+} telemetry_readers[TOF2CAN_MAX_SENSOR_COUNT];
+
+static void handle_telemetry(int sensor, const void *data, int len) {
+    // check if message size is correct
+    if(len != TOF2CAN_TELEMETRY_SIZE)
+        return;
+
+    struct tof2can_telemetry page;
+    memcpy(&page, data, sizeof(page));
+
+    if(page.page >= TOF2CAN_TELEMETRY_PAGE_COUNT)
+        return;
+
+    // pages are sent in order: a report is complete if no page is lost
+    if(page.page == 0 || page.sequence != telemetry_readers[sensor].sequence)
+        telemetry_readers[sensor].pages_received = 0;
+    if(page.page != telemetry_readers[sensor].pages_received)
+        return;
+
+    telemetry_readers[sensor].sequence = page.sequence;
+    telemetry_readers[sensor].pages_received++;
+    memcpy(
+        &telemetry_readers[sensor].values[page.page * 3], page.values,
+        sizeof(page.values)
+    );
+
+    // wait until the report is complete
+    if(page.page != TOF2CAN_TELEMETRY_PAGE_COUNT - 1)
+        return;
+
+    uint64_t *totals = telemetry_readers[sensor].totals;
+    uint16_t *last   = telemetry_readers[sensor].last;
+    bool *received   = telemetry_readers[sensor].received;
+    const uint16_t *values = telemetry_readers[sensor].values;
+
+    // if the uptime went backwards, the sensor rebooted and its counters
+    // started again from zero
+    const int uptime = TOF2CAN_TELEMETRY_UPTIME;
+    if(received[uptime] && (int16_t) (values[uptime] - last[uptime]) < 0)
+        memset(received, 0, TOF2CAN_TELEMETRY_VALUE_COUNT * sizeof(bool));
+
+    for(int v = 0; v < TOF2CAN_TELEMETRY_VALUE_COUNT; v++) {
+        // counters wrap around at 16 bits: add the difference
+        if(v == TOF2CAN_TELEMETRY_LOOP_RATE || !received[v])
+            totals[v] = values[v];
+        else
+            totals[v] += (uint16_t) (values[v] - last[v]);
+
+        last[v]     = values[v];
+        received[v] = true;
+    }
+
+    struct libtofcan_telemetry *telemetry = &telemetry_readers[sensor].data;
+    *telemetry = (struct libtofcan_telemetry) {
+        .frames_acquired   = totals[TOF2CAN_TELEMETRY_FRAMES_ACQUIRED],
+        .frames_sent       = totals[TOF2CAN_TELEMETRY_FRAMES_SENT],
+        .frames_suppressed = totals[TOF2CAN_TELEMETRY_FRAMES_SUPPRESSED],
+        .can_write_errors  = totals[TOF2CAN_TELEMETRY_CAN_WRITE_ERRORS],
+        .i2c_errors        = totals[TOF2CAN_TELEMETRY_I2C_ERRORS],
+        .rx_overruns       = totals[TOF2CAN_TELEMETRY_RX_OVERRUNS],
+        .tx_dropped        = totals[TOF2CAN_TELEMETRY_TX_DROPPED],
+        .uptime            = totals[TOF2CAN_TELEMETRY_UPTIME],
+
+        .loop_rate = totals[TOF2CAN_TELEMETRY_LOOP_RATE],
+        .reports   = telemetry->reports + 1
+    };
+
+    if(callbacks.telemetry)
+        callbacks.telemetry(sensor, telemetry);
+}
+
+bool libtofcan_get_telemetry(int sensor,
+                             struct libtofcan_telemetry *data) {
+    if(sensor < 0 || sensor >= TOF2CAN_MAX_SENSOR_COUNT)
+        return false;
+
+    const struct libtofcan_telemetry *telemetry =
+        &telemetry_readers[sensor].data;
+    if(telemetry->reports == 0)
+        return false;
+
+    *data = *telemetry;
+    return true;
+}
+
+// profile messages received so far, for each sensor
+static struct {
+    uint16_t words[TOF2CAN_PROFILE_STEP_COUNT]
+                  [TOF2CAN_PROFILE_PAGE_COUNT * 3];
+    int messages_received;
+} profile_readers[TOF2CAN_MAX_SENSOR_COUNT];
+
+static inline uint32_t get_profile_value(const uint16_t *words, int i) {
+    return words[i] | (uint32_t) words[i + 1] << 16;
+}
+
+static void profile_complete(int sensor, bool valid) {
+    struct libtofcan_profile profile;
+
+    for(int s = 0; s < TOF2CAN_PROFILE_STEP_COUNT; s++) {
+        const uint16_t *words = profile_readers[sensor].words[s];
+
+        profile.steps[s].count = get_profile_value(words, 0);
+        profile.steps[s].min   = get_profile_value(words, 2);
+        profile.steps[s].max   = get_profile_value(words, 4);
+        profile.steps[s].mean  = get_profile_value(words, 6);
+        for(int b = 0; b < TOF2CAN_PROFILE_BUCKET_COUNT; b++)
+            profile.steps[s].histogram[b] = words[9 + b];
+
+        profile.cycles_per_us = words[8];
+    }
+
+    if(callbacks.profile)
+        callbacks.profile(sensor, &profile, valid);
+}
+
+static void handle_profile(int sensor, const void *data, int len) {
+    // check if message size is correct
+    if(len != TOF2CAN_PROFILE_SIZE)
+        return;
+
+    struct tof2can_profile page;
+    memcpy(&page, data, sizeof(page));
+
+    if(page.step >= TOF2CAN_PROFILE_STEP_COUNT ||
+       page.page >= TOF2CAN_PROFILE_PAGE_COUNT)
+        return;
+
+    // messages are sent in order: the first one starts a new reply
+    int *received = &profile_readers[sensor].messages_received;
+    if(page.step == 0 && page.page == 0)
+        *received = 0;
+
+    memcpy(
+        &profile_readers[sensor].words[page.step][page.page * 3],
+        page.words, sizeof(page.words)
+    );
+    (*received)++;
+
+    // the last message completes the reply
+    if(page.step == TOF2CAN_PROFILE_STEP_COUNT - 1 &&
+       page.page == TOF2CAN_PROFILE_PAGE_COUNT - 1) {
+        const int expected = (
+            TOF2CAN_PROFILE_STEP_COUNT * TOF2CAN_PROFILE_PAGE_COUNT
+        );
+        profile_complete(sensor, *received == expected);
+        *received = 0;
+    }
 }
 
 void libtofcan_receive(const struct libtofcan_msg *msg) {
@@ -152,9 +669,29 @@ void libtofcan_receive(const struct libtofcan_msg *msg) {
             handle_sample(sensor, msg->data, msg->len);
             break;
 
+        case TOF2CAN_TIMESTAMP_MASK_ID:
+            handle_timestamp(sensor, msg->data, msg->len);
+            break;
+
         case TOF2CAN_DATA_PACKET_MASK_ID:
             handle_data_packet(sensor, msg->data, msg->len);
             break;
+
+        case TOF2CAN_PACKED_PACKET_MASK_ID:
+            handle_packed_packet(sensor, msg->data, msg->len);
+            break;
+
+        case TOF2CAN_STORAGE_MASK_ID:
+            handle_storage(sensor, msg->data, msg->len);
+            break;
+
+        case TOF2CAN_TELEMETRY_MASK_ID:
+            handle_telemetry(sensor, msg->data, msg->len);
+            break;
+
+        case TOF2CAN_PROFILE_MASK_ID:
+            handle_profile(sensor, msg->data, msg->len);
+            break;
     }
 }
 
@@ -211,6 +748,10 @@ void libtofcan_config_string(struct tof2can_config *config,
         "above threshold event", "any threshold event"
     }[config->transmit_condition & 3];
 
+    const char *encoding_str = (const char *[]) {
+        "16-bit", "packed 12-bit"
+    }[config->data_encoding & 1];
+
     printf("-> %d\n\n", snprintf(
         str, maxlen,
         "resolution: %d points\n"
@@ -219,9 +760,10 @@ void libtofcan_config_string(struct tof2can_config *config,
         "threshold: %d mm\n"
         "threshold delay: %d\n"
         "transmit timing: %s\n"
-        "transmit condition: %s",
+        "transmit condition: %s\n"
+        "data encoding: %s",
         config->resolution, config->frequency, mode_str,
         config->threshold, config->threshold_delay,
-        timing_str, condition_str
+        timing_str, condition_str, encoding_str
     ));
 }